@@ -40,21 +40,345 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <sstream>
 #include <algorithm>
 #include <type_traits>
+#include <string_view>
+#include <optional>
+#include <charconv>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <utility>
+#include <chrono>
+#include <limits>
+#include <cerrno>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 /**
  * @brief Macro to call reflect with mode = List, each variable/sub-var is printed in new lines.
  */
-#define CppReflectAsList(...) CppReflection::reflect(CppReflection::List, #__VA_ARGS__, __VA_ARGS__)
+#define CppReflectAsList(...) CppReflection::reflect(CppReflection::List, \
+      CppReflectCallSite(__VA_ARGS__), __VA_ARGS__)
 
 /**
  * @brief Macro to call reflect with mode = CSV, to print variables in comma separated way
  */
-#define CppReflectAsCSV(...) CppReflection::reflect(CppReflection::CSV, #__VA_ARGS__, __VA_ARGS__)
+#define CppReflectAsCSV(...) CppReflection::reflect(CppReflection::CSV, \
+      CppReflectCallSite(__VA_ARGS__), __VA_ARGS__)
 
 /**
- * @brief Macro to call reflect with mode that was set using last *As* macros. 
+ * @brief Macro to call reflect with mode = Binary, to encode variables in a compact
+ * binary form (see CppReflection::binaryTag). tools/cppReflectDecode renders it
+ * back into List/CSV text.
  */
-#define CppReflect(...) CppReflection::reflect(CppReflection::mode, #__VA_ARGS__, __VA_ARGS__)
+#define CppReflectAsBinary(...) CppReflection::reflect(CppReflection::Binary, \
+      CppReflectCallSite(__VA_ARGS__), __VA_ARGS__)
+
+/**
+ * @brief Macro to call reflect with mode = JSON, to print variables as one JSON 
+ * object (terminated by a newline) mirroring their container/tuple/object structure.
+ */
+#define CppReflectAsJSON(...) CppReflection::reflect(CppReflection::JSON, \
+      CppReflectCallSite(__VA_ARGS__), __VA_ARGS__)
+
+/**
+ * @brief Macro to call reflect with mode of the enclosing reflection, if any, else the 
+ * mode that was set using last *As* macros on this thread.
+ */
+#define CppReflect(...) CppReflection::reflect(CppReflection::context::currentMode(), \
+      CppReflectCallSite(__VA_ARGS__), __VA_ARGS__)
+
+/**
+ * @brief Macro to reflect into a sink using the mode of the enclosing reflection, if any,
+ * else the mode that was set using last *As* macros on this thread.
+ * Sink can be a std::ostream&, a std::string& to append to, a 
+ * CppReflection::charBuffer (or char array), a CppReflection::fdSink, a 
+ * CppReflection::callbackSink, a CppReflection::ringFile or the
+ * CppReflection::context passed to a 'reflect(CppReflection::context&)' API.
+ * A braced sink with a comma has to be put in parentheses, e.g.
+ * CppReflectTo((CppReflection::charBuffer{buf, size}), a, b).
+ * Returns the number of bytes written.
+ */
+#define CppReflectTo(sink, ...) CppReflection::reflectTo(sink, CppReflection::context::currentMode(), \
+      CppReflectCallSite(__VA_ARGS__), __VA_ARGS__)
+
+/**
+ * @brief Macro to reflect into a sink with mode = List.
+ */
+#define CppReflectAsListTo(sink, ...) CppReflection::reflectTo(sink, CppReflection::List, \
+      CppReflectCallSite(__VA_ARGS__), __VA_ARGS__)
+
+/**
+ * @brief Macro to reflect into a sink with mode = CSV.
+ */
+#define CppReflectAsCSVTo(sink, ...) CppReflection::reflectTo(sink, CppReflection::CSV, \
+      CppReflectCallSite(__VA_ARGS__), __VA_ARGS__)
+
+/**
+ * @brief Macro to reflect into a sink with mode = Binary.
+ */
+#define CppReflectAsBinaryTo(sink, ...) CppReflection::reflectTo(sink, CppReflection::Binary, \
+      CppReflectCallSite(__VA_ARGS__), __VA_ARGS__)
+
+/**
+ * @brief Macro to reflect into a sink with mode = JSON.
+ */
+#define CppReflectAsJSONTo(sink, ...) CppReflection::reflectTo(sink, CppReflection::JSON, \
+      CppReflectCallSite(__VA_ARGS__), __VA_ARGS__)
+
+/**
+ * @brief Macro to capture variables on the calling thread and reflect them
+ * later on the background thread of CppReflection::asyncQueue::global(), 
+ * which prints them in List mode on std::cout. Returns false if the capture
+ * was dropped because the queue was full.
+ */
+#define CppReflectAsync(...) CppReflection::asyncQueue::global().push( \
+      CppReflectCallSite(__VA_ARGS__), __VA_ARGS__)
+
+/**
+ * @brief Macro to capture variables on the calling thread and reflect them
+ * later on the background thread of the given CppReflection::asyncQueue.
+ */
+#define CppReflectAsyncTo(queue, ...) (queue).push( \
+      CppReflectCallSite(__VA_ARGS__), __VA_ARGS__)
+
+/**
+ * @brief Macro to reflect variables through a CppReflection::snapshot: only
+ * the elements added, modified or removed since the previous reflection 
+ * through the same snapshot are printed, in the mode of the snapshot.
+ * Returns the output as a string.
+ */
+#define CppReflectDiff(snap, ...) CppReflection::reflectDiff(snap, \
+      CppReflectCallSite(__VA_ARGS__), __VA_ARGS__)
+
+/**
+ * @brief Same as CppReflectDiff, but writes into a sink (see CppReflectTo)
+ */
+#define CppReflectDiffTo(snap, sink, ...) CppReflection::reflectDiffTo(snap, sink, \
+      CppReflectCallSite(__VA_ARGS__), __VA_ARGS__)
+
+/**
+ * @brief Macros to reflect only some of the calls of a call site in a hot
+ * loop, e.g. CppReflectEveryN(1000, CppReflectAsListTo(std::cout, a, b)).
+ * reflection is any of the macros above, it is not evaluated at all for
+ * suppressed calls, which return an empty string / 0 / false instead.
+ * CppReflectEveryN reflects the 1st, (n+1)th, (2n+1)th... calls, 
+ * CppReflectFirstN the first n calls only and CppReflectPerSecond at most 
+ * n calls per second (see CppReflection::sampler).
+ */
+#define CppReflectEveryN(n, reflection) \
+   (CppReflectSampler().everyN(n) ? (reflection) : CppReflection::suppressed())
+
+#define CppReflectFirstN(n, reflection) \
+   (CppReflectSampler().firstN(n) ? (reflection) : CppReflection::suppressed())
+
+#define CppReflectPerSecond(n, reflection) \
+   (CppReflectSampler().perSecond(n) ? (reflection) : CppReflection::suppressed())
+
+/**
+ * @brief Verbosity levels of the CppReflectTrace/Debug/Info macros. Call
+ * sites below CPPREFLECT_MIN_LEVEL (define it before including this file,
+ * e.g. -DCPPREFLECT_MIN_LEVEL=CPPREFLECT_LEVEL_INFO for release builds) 
+ * are compiled out, CPPREFLECT_LEVEL_OFF compiles all of them out.
+ */
+#define CPPREFLECT_LEVEL_TRACE 0
+#define CPPREFLECT_LEVEL_DEBUG 1
+#define CPPREFLECT_LEVEL_INFO 2
+#define CPPREFLECT_LEVEL_OFF 3
+
+#ifndef CPPREFLECT_MIN_LEVEL
+#define CPPREFLECT_MIN_LEVEL CPPREFLECT_LEVEL_TRACE
+#endif
+
+/**
+ * @brief Macros to reflect at a verbosity level, e.g. 
+ * CppReflectDebug(CppReflectAsListTo(std::cout, a, b)). reflection is any
+ * of the macros above, it is evaluated only if the level is enabled at run
+ * time too (see CppReflection::setLevel), else an empty string / 0 / false
+ * is returned. Below CPPREFLECT_MIN_LEVEL the reflection is dropped by the
+ * preprocessor: its arguments are not evaluated, nothing is instantiated 
+ * and its variable names don't end up in the binary. It is replaced by an
+ * empty std::string, a std::size_t 0 or false (see CppReflectOff_), so 
+ * the call site compiles the same way (+=, <<, auto) at every level.
+ */
+#if CPPREFLECT_MIN_LEVEL <= CPPREFLECT_LEVEL_TRACE
+#define CppReflectTrace(reflection) CppReflectAtLevel(CppReflection::Trace, reflection)
+#else
+#define CppReflectTrace(reflection) CppReflectOff_##reflection
+#endif
+
+#if CPPREFLECT_MIN_LEVEL <= CPPREFLECT_LEVEL_DEBUG
+#define CppReflectDebug(reflection) CppReflectAtLevel(CppReflection::Debug, reflection)
+#else
+#define CppReflectDebug(reflection) CppReflectOff_##reflection
+#endif
+
+#if CPPREFLECT_MIN_LEVEL <= CPPREFLECT_LEVEL_INFO
+#define CppReflectInfo(reflection) CppReflectAtLevel(CppReflection::Info, reflection)
+#else
+#define CppReflectInfo(reflection) CppReflectOff_##reflection
+#endif
+
+/**
+ * @brief Helper macros for the leveled macros above: what a compiled out 
+ * reflection becomes, picked by pasting the name of its macro. Only its 
+ * type is kept, the value a disabled reflection returns.
+ */
+#define CppReflectOff_CppReflectAsList(...) (std::string())
+#define CppReflectOff_CppReflectAsCSV(...) (std::string())
+#define CppReflectOff_CppReflectAsBinary(...) (std::string())
+#define CppReflectOff_CppReflectAsJSON(...) (std::string())
+#define CppReflectOff_CppReflect(...) (std::string())
+#define CppReflectOff_CppReflectDiff(...) (std::string())
+#define CppReflectOff_CppReflectTo(...) (std::size_t(0))
+#define CppReflectOff_CppReflectAsListTo(...) (std::size_t(0))
+#define CppReflectOff_CppReflectAsCSVTo(...) (std::size_t(0))
+#define CppReflectOff_CppReflectAsBinaryTo(...) (std::size_t(0))
+#define CppReflectOff_CppReflectAsJSONTo(...) (std::size_t(0))
+#define CppReflectOff_CppReflectDiffTo(...) (std::size_t(0))
+#define CppReflectOff_CppReflectAsync(...) (false)
+#define CppReflectOff_CppReflectAsyncTo(...) (false)
+#define CppReflectOff_CppReflectEveryN(n, reflection) CppReflectOff_##reflection
+#define CppReflectOff_CppReflectFirstN(n, reflection) CppReflectOff_##reflection
+#define CppReflectOff_CppReflectPerSecond(n, reflection) CppReflectOff_##reflection
+#define CppReflectOff_CppReflectTrace(reflection) CppReflectOff_##reflection
+#define CppReflectOff_CppReflectDebug(reflection) CppReflectOff_##reflection
+#define CppReflectOff_CppReflectInfo(reflection) CppReflectOff_##reflection
+
+/**
+ * @brief Helper macro for the leveled macros above
+ */
+#define CppReflectAtLevel(level, reflection) \
+   (CppReflection::levelEnabled(level) ? (reflection) : CppReflection::suppressed())
+
+/**
+ * @brief Helper macro which yields a reference to the static sampler of the
+ * macro call.
+ */
+#define CppReflectSampler() \
+   ([]() -> CppReflection::sampler& { \
+      static CppReflection::sampler sampler_; \
+      return sampler_; }())
+
+/**
+ * @brief Define CPPREFLECT_INSTRUMENT to 1 (the same way in every translation
+ * unit) to keep per call site statistics of the reflection macros: calls,
+ * time, bytes, elements and truncations (see CppReflection::siteStats).
+ * Compiled out by default, which leaves no trace of it in the code.
+ */
+#ifndef CPPREFLECT_INSTRUMENT
+#define CPPREFLECT_INSTRUMENT 0
+#endif
+
+/**
+ * @brief Helper macros counting elements visited / truncations for the
+ * statistics of the running top level reflection
+ */
+#if CPPREFLECT_INSTRUMENT
+#define CppReflectCountElements_(n) (CppReflection::threadSiteCounters::elements() += (n))
+#define CppReflectCountTruncation_() (CppReflection::threadSiteCounters::truncations()++)
+#else
+#define CppReflectCountElements_(n) ((void)0)
+#define CppReflectCountTruncation_() ((void)0)
+#endif
+
+/**
+ * @brief Helper macro which yields a reference to the static callSite of the
+ * macro call. It holds a constexpr table of the (whitespace stripped) names of
+ * all the variables passed to it, built by the compiler once per call site,
+ * so no name parsing happens at run time.
+ */
+#if CPPREFLECT_INSTRUMENT
+#define CppReflectCallSite(...) \
+   ([]() -> auto& { \
+      static constexpr auto nameTable_ = CppReflection::splitNames< \
+         CppReflection::countNames(#__VA_ARGS__)>(#__VA_ARGS__); \
+      static CppReflection::callSite<CppReflection::countNames(#__VA_ARGS__)> \
+         callSite_{nameTable_.list(), __FILE__, __LINE__}; \
+      return callSite_; }())
+#else
+#define CppReflectCallSite(...) \
+   ([]() -> auto& { \
+      static constexpr auto nameTable_ = CppReflection::splitNames< \
+         CppReflection::countNames(#__VA_ARGS__)>(#__VA_ARGS__); \
+      static CppReflection::callSite<CppReflection::countNames(#__VA_ARGS__)> \
+         callSite_{nameTable_.list()}; \
+      return callSite_; }())
+#endif
+
+/**
+ * @brief Macro registering fields of a class for reflection, to be placed in
+ * the class body (it declares a friend, so private members can be listed): 
+ * CPPREFLECT_FIELDS(Foo, a, b, c). It builds, once, a constexpr table of the
+ * names and member pointers of the fields (see CppReflection::fieldTable), 
+ * which the reflection walks straight into the output of every mode. 
+ * CppReflection::forEachField iterates over the fields too. Up to 32 fields.
+ */
+#define CPPREFLECT_FIELDS(Type, ...) \
+   friend const auto& cppReflectFields(const Type*) \
+   { \
+      static constexpr auto nameTable_ = CppReflection::splitNames< \
+         CppReflection::countNames(#__VA_ARGS__)>(#__VA_ARGS__); \
+      static CppReflection::callSite<CppReflection::countNames(#__VA_ARGS__)> \
+         callSite_{nameTable_.list()}; \
+      static constexpr auto fields_ = CppReflection::makeFieldTable(callSite_, \
+         CppReflectMemberPointers(Type, __VA_ARGS__)); \
+      return fields_; \
+   }
+
+/**
+ * @brief Helper macros expanding to &Type::field for each field
+ */
+#define CppReflectMemberPointers(Type, ...) CppReflectPickForEach_(__VA_ARGS__, \
+      CppReflectForEach32_, CppReflectForEach31_, CppReflectForEach30_, CppReflectForEach29_, CppReflectForEach28_, CppReflectForEach27_, CppReflectForEach26_, CppReflectForEach25_, CppReflectForEach24_, CppReflectForEach23_, CppReflectForEach22_, CppReflectForEach21_, CppReflectForEach20_, CppReflectForEach19_, CppReflectForEach18_, CppReflectForEach17_, CppReflectForEach16_, CppReflectForEach15_, CppReflectForEach14_, CppReflectForEach13_, CppReflectForEach12_, CppReflectForEach11_, CppReflectForEach10_, CppReflectForEach9_, CppReflectForEach8_, CppReflectForEach7_, CppReflectForEach6_, CppReflectForEach5_, CppReflectForEach4_, CppReflectForEach3_, CppReflectForEach2_, CppReflectForEach1_)(CppReflectMemberPointer_, Type, __VA_ARGS__)
+#define CppReflectMemberPointer_(Type, field) &Type::field
+#define CppReflectForEach1_(m, Type, field) m(Type, field)
+#define CppReflectForEach2_(m, Type, field, ...) m(Type, field), CppReflectForEach1_(m, Type, __VA_ARGS__)
+#define CppReflectForEach3_(m, Type, field, ...) m(Type, field), CppReflectForEach2_(m, Type, __VA_ARGS__)
+#define CppReflectForEach4_(m, Type, field, ...) m(Type, field), CppReflectForEach3_(m, Type, __VA_ARGS__)
+#define CppReflectForEach5_(m, Type, field, ...) m(Type, field), CppReflectForEach4_(m, Type, __VA_ARGS__)
+#define CppReflectForEach6_(m, Type, field, ...) m(Type, field), CppReflectForEach5_(m, Type, __VA_ARGS__)
+#define CppReflectForEach7_(m, Type, field, ...) m(Type, field), CppReflectForEach6_(m, Type, __VA_ARGS__)
+#define CppReflectForEach8_(m, Type, field, ...) m(Type, field), CppReflectForEach7_(m, Type, __VA_ARGS__)
+#define CppReflectForEach9_(m, Type, field, ...) m(Type, field), CppReflectForEach8_(m, Type, __VA_ARGS__)
+#define CppReflectForEach10_(m, Type, field, ...) m(Type, field), CppReflectForEach9_(m, Type, __VA_ARGS__)
+#define CppReflectForEach11_(m, Type, field, ...) m(Type, field), CppReflectForEach10_(m, Type, __VA_ARGS__)
+#define CppReflectForEach12_(m, Type, field, ...) m(Type, field), CppReflectForEach11_(m, Type, __VA_ARGS__)
+#define CppReflectForEach13_(m, Type, field, ...) m(Type, field), CppReflectForEach12_(m, Type, __VA_ARGS__)
+#define CppReflectForEach14_(m, Type, field, ...) m(Type, field), CppReflectForEach13_(m, Type, __VA_ARGS__)
+#define CppReflectForEach15_(m, Type, field, ...) m(Type, field), CppReflectForEach14_(m, Type, __VA_ARGS__)
+#define CppReflectForEach16_(m, Type, field, ...) m(Type, field), CppReflectForEach15_(m, Type, __VA_ARGS__)
+#define CppReflectForEach17_(m, Type, field, ...) m(Type, field), CppReflectForEach16_(m, Type, __VA_ARGS__)
+#define CppReflectForEach18_(m, Type, field, ...) m(Type, field), CppReflectForEach17_(m, Type, __VA_ARGS__)
+#define CppReflectForEach19_(m, Type, field, ...) m(Type, field), CppReflectForEach18_(m, Type, __VA_ARGS__)
+#define CppReflectForEach20_(m, Type, field, ...) m(Type, field), CppReflectForEach19_(m, Type, __VA_ARGS__)
+#define CppReflectForEach21_(m, Type, field, ...) m(Type, field), CppReflectForEach20_(m, Type, __VA_ARGS__)
+#define CppReflectForEach22_(m, Type, field, ...) m(Type, field), CppReflectForEach21_(m, Type, __VA_ARGS__)
+#define CppReflectForEach23_(m, Type, field, ...) m(Type, field), CppReflectForEach22_(m, Type, __VA_ARGS__)
+#define CppReflectForEach24_(m, Type, field, ...) m(Type, field), CppReflectForEach23_(m, Type, __VA_ARGS__)
+#define CppReflectForEach25_(m, Type, field, ...) m(Type, field), CppReflectForEach24_(m, Type, __VA_ARGS__)
+#define CppReflectForEach26_(m, Type, field, ...) m(Type, field), CppReflectForEach25_(m, Type, __VA_ARGS__)
+#define CppReflectForEach27_(m, Type, field, ...) m(Type, field), CppReflectForEach26_(m, Type, __VA_ARGS__)
+#define CppReflectForEach28_(m, Type, field, ...) m(Type, field), CppReflectForEach27_(m, Type, __VA_ARGS__)
+#define CppReflectForEach29_(m, Type, field, ...) m(Type, field), CppReflectForEach28_(m, Type, __VA_ARGS__)
+#define CppReflectForEach30_(m, Type, field, ...) m(Type, field), CppReflectForEach29_(m, Type, __VA_ARGS__)
+#define CppReflectForEach31_(m, Type, field, ...) m(Type, field), CppReflectForEach30_(m, Type, __VA_ARGS__)
+#define CppReflectForEach32_(m, Type, field, ...) m(Type, field), CppReflectForEach31_(m, Type, __VA_ARGS__)
+#define CppReflectPickForEach_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
 
 /**
  * @brief Name-space to encompass each struct/variable/functions for * CppReflection library
@@ -62,454 +386,4528 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 namespace CppReflection {
 
    /**
-    * @brief Unnamed namespace to hide all the helper struct/variable/functions from outside.
+    * @brief View of the nameTable of a call site, the same type whatever the
+    * length and number of names, so code using it is instantiated once.
     */
-   namespace { 
+   struct nameList {
+      const char* buf;
+      const std::size_t* off;
+      const std::size_t* len;
+      std::size_t count;
 
-      /**
-       * @brief Defines modes that can be used to change output of reflection
-       */
-      enum modeList { List=0, CSV, ModeCount};
+      constexpr std::size_t size() const { return count; }
 
-      /**
-       * @brief Static variable inside namespace to store current mode being used
-       */
-      static modeList mode = List;
+      constexpr std::string_view operator[](std::size_t i) const
+      { return std::string_view(buf + off[i], len[i]); }
+   };
 
-      /**
-       * @brief Static depth variable to keep track of indentation that need to
-       * be printed while printing any line as per depth of the sub-variable
-       * that we are printing.
-       */
-      static int depth = -1;
+   /**
+    * @brief Compile time table of variable names of one call site.
+    *
+    * Names are stored back to back in buf (with white-spaces removed) and
+    * are looked up by their offset and length.
+    *
+    * @tparam Len size of the stringized argument list (upper bound of buf)
+    * @tparam N number of names in the table
+    */
+   template<std::size_t Len, std::size_t N>
+      struct nameTable {
+         char buf[Len] = {};
+         std::size_t off[N == 0 ? 1 : N] = {};
+         std::size_t len[N == 0 ? 1 : N] = {};
 
-      /**
-       * @brief typedef to define delimiters depending on mode.
-       */
-      typedef std::array<std::string, ModeCount> delimList;
+         static constexpr std::size_t size() { return N; }
 
-      /**
-       * @brief Delimiter to be printed before variable-value pair.
-       *
-       * @return delimiter string
-       */
-      auto beginDelim = [&](){ 
-         static const delimList delims = { "\t", "" };
-         std::string ret = ""; auto loopCtr = depth;
-         while(loopCtr--) ret += delims.at(mode); 
-         return ret;};
+         constexpr std::string_view operator[](std::size_t i) const
+         { return std::string_view(buf + off[i], len[i]); }
 
-      /**
-       * @brief Delimiter to be printed between variable-value pair.
-       *
-       * @return delimiter string
-       */
-      auto middleDelim = [&](){ 
-         static const delimList delims = { " = ", " , " };
-         return delims.at(mode);};
+         constexpr nameList list() const { return nameList{buf, off, len, N}; }
+      };
 
-      /**
-       * @brief Delimiter to be printed after variable-value pair.
-       *
-       * @return delimiter string
-       */
-      auto endDelim = [&](){ 
-         static const delimList delims = { "\n", " , " };
-         return delims.at(mode);};
+   /**
+    * @brief Next free call site id
+    */
+   inline std::atomic<std::uint32_t>& nextCallSiteId()
+   {
+      static std::atomic<std::uint32_t> id(1);
+      return id;
+   }
 
-      /**
-       * @brief Increment static variable depth
-       */
-      auto incrDepth = [&]() { depth++ ;};
+   /**
+    * @brief Binary mode sends the names of a call site only the first time it
+    * is used in the current epoch. 
+    */
+   inline std::atomic<std::uint32_t>& binaryNamesEpoch()
+   {
+      static std::atomic<std::uint32_t> epoch(1);
+      return epoch;
+   }
+
+   /**
+    * @brief Make Binary mode send names of every call site again, e.g. when
+    * starting to write into a new file. Only needed for sinks (see 
+    * CppReflectAsBinaryTo): returned strings and ringFile records always 
+    * carry the names they use.
+    */
+   inline void resetBinaryNames()
+   {
+      binaryNamesEpoch().fetch_add(1, std::memory_order_relaxed);
+   }
+
+   /**
+    * @brief Static, per macro call, data: the names plus state that has to be
+    * kept per call site. Constant initialized, so using it costs no 
+    * guard/lock.
+    */
+   struct callSiteState {
+#if CPPREFLECT_INSTRUMENT
+      constexpr explicit callSiteState(nameList names_, const char* file_ = "", 
+                                       unsigned line_ = 0) 
+         : names(names_), file(file_), line(line_) {}
+#else
+      constexpr explicit callSiteState(nameList names_) : names(names_) {}
+#endif
+
+      const nameList names;
+      std::atomic<std::uint32_t> id_{0};
+      std::atomic<std::uint32_t> binaryEpoch_{0};
+#if CPPREFLECT_INSTRUMENT
+      const char* const file;
+      const unsigned line;
+      std::atomic<bool> statsRegistered_{false};
+#endif
 
       /**
-       * @brief Decrement static variable depth
+       * @brief Process wide unique id of the call site, assigned on first use
        */
-      auto decrDepth = [&]() { depth-- ;};
+      std::uint32_t id()
+      {
+         std::uint32_t ret = id_.load(std::memory_order_relaxed);
+         if(ret) return ret;
+         std::uint32_t fresh = nextCallSiteId().fetch_add(1, std::memory_order_relaxed);
+         return id_.compare_exchange_strong(ret, fresh, std::memory_order_relaxed) ? fresh : ret;
+      }
 
       /**
-       * @brief Struct to encapsulate constexpr traits of a datatype w.r.t a * stream
-       *
-       * @tparam TStream stream on which we are trying to print the variable
-       * @tparam T datatype of the variable
+       * @brief true (once per binaryNamesEpoch) if Binary mode has to send
+       * the names of this call site
        */
-      template<typename TStream, typename T>
-         struct stream_var {
-            private:
+      bool claimBinaryNames()
+      {
+         const std::uint32_t epoch = binaryNamesEpoch().load(std::memory_order_relaxed);
+         if(binaryEpoch_.load(std::memory_order_relaxed) == epoch) return false;
+         return binaryEpoch_.exchange(epoch, std::memory_order_relaxed) != epoch;
+      }
+   };
 
-               /**
-                * @brief  TStream_ type has a << operator 
-                */
-               template<typename TStream_, typename T_>
-                  static constexpr 
-                  decltype(std::declval<TStream_>().operator<<(std::declval<T_>()), bool())
-                  test_ltlt1(int) 
-                  { return true; };
-
-               /**
-                * @brief  TStream_ type doesn't have a << operator 
-                */
-               template<typename TStream_, typename T_>
-                  static constexpr 
-                  bool
-                  test_ltlt1(...) 
-                  { return false; };
-
-               /**
-                * @brief  std::<< operator works with TStream_ type and T_ * type
-                */
-               template<typename TStream_, typename T_>
-                  static constexpr 
-                  decltype(operator<<(std::declval<TStream_&>(), std::declval<T_>()), bool())
-                  test_ltlt2(int) 
-                  { return true; };
-
-               /**
-                * @brief  std::<< operator doesn't work with TStream_ type and T_ * type
-                */
-               template<typename TStream_, typename T_>
-                  static constexpr 
-                  bool
-                  test_ltlt2(...) 
-                  { return false; };
-
-
-               /**
-                * @brief class T_ has an API called reflect
-                */
-               template<typename TStream_, typename T_>
-                  static constexpr 
-                  decltype(std::declval<T_>().reflect(), bool())
-                  test_reflectAPI(int) 
-                  { return true; };
-
-               /**
-                * @brief class T_ doesn't have an API called reflect
-                */
-               template<typename TStream_, typename T_>
-                  static constexpr 
-                  bool
-                  test_reflectAPI(...) 
-                  { return false; };
-
-
-               /**
-                * @brief T_ type has a begin() API
-                */
-               template<typename TStream_, typename T_>
-                  static constexpr 
-                  decltype(std::declval<T_>().begin(), bool())
-                  test_begin(int) 
-                  { return true; };
-
-               /**
-                * @brief T_ type doesn't have a begin() API
-                */
-               template<typename TStream_, typename T_>
-                  static constexpr 
-                  bool
-                  test_begin(...) 
-                  { return false; };
-
-               /**
-                * @brief T_ type has a end() API
-                */
-               template<typename TStream_, typename T_>
-                  static constexpr 
-                  decltype(std::declval<T_>().end(), bool())
-                  test_end(int) 
-                  { return true; };
-
-               /**
-                * @brief T_ type doesn't have a end() API
-                */
-               template<typename TStream_, typename T_>
-                  static constexpr 
-                  bool
-                  test_end(...) 
-                  { return false; };
-
-               /**
-                * @brief T_ type has a size() API
-                */
-               template<typename TStream_, typename T_>
-                  static constexpr 
-                  decltype(std::declval<T_>().size(), bool())
-                  test_size(int) 
-                  { return true; };
-
-               /**
-                * @brief T_ type doesn't have a size() API
-                */
-               template<typename TStream_, typename T_>
-                  static constexpr 
-                  bool
-                  test_size(...) 
-                  { return false; };
-
-               /**
-                * @brief T_ is a tuple type (std::tuple, std::pair, etc..)
-                */
-               template<typename TStream_, typename T_>
-                  static constexpr 
-                  decltype(std::tuple_size<T_>::value, bool())
-                  test_tuple(int) 
-                  { return true; };
-
-               /**
-                * @brief T_ is not a tuple type (std::tuple, std::pair, etc..)
-                */
-               template<typename TStream_, typename T_>
-                  static constexpr 
-                  bool
-                  test_tuple(...) 
-                  { return false; };
+   /**
+    * @brief callSiteState of a macro call with N variables. N is only 
+    * checked against the variables passed, everything else works on the
+    * callSiteState.
+    */
+   template<std::size_t N>
+      struct callSite : callSiteState {
+#if CPPREFLECT_INSTRUMENT
+         constexpr explicit callSite(nameList names_, const char* file_ = "", unsigned line_ = 0) 
+            : callSiteState(names_, file_, line_) {}
+#else
+         constexpr explicit callSite(nameList names_) : callSiteState(names_) {}
+#endif
+      };
 
+   /**
+    * @brief Fields of a class registered with CPPREFLECT_FIELDS: the call 
+    * site holding their names (and Binary id) and their member pointers, in
+    * the same order.
+    */
+   template<typename... M>
+      struct fieldTable {
+         callSiteState& site;
+         std::tuple<M...> members;
+      };
 
+   template<typename... M>
+      constexpr fieldTable<M...> makeFieldTable(callSiteState& site, M... members)
+      {
+         return fieldTable<M...>{site, std::tuple<M...>(members...)};
+      }
 
-            public:
-               static constexpr bool has_size = test_size<TStream, T>(int());
-               static constexpr bool has_begin = test_begin<TStream, T>(int());
-               static constexpr bool has_end = test_end<TStream, T>(int());
-               static constexpr bool has_ltlt = ( test_ltlt1<TStream, T>(int()) || 
-                                                  test_ltlt2<TStream, T>(int()));
-               static constexpr bool has_reflect = test_reflectAPI<TStream, T>(int());
-               static constexpr bool is_container = ( !has_ltlt && 
-                                                       has_size && 
-                                                       has_begin && 
-                                                       has_end );
-               static constexpr bool is_tuple = ( test_tuple<TStream, T>(int()) &&
-                                                       !is_container ) ;
-               static constexpr bool not_printable = !( is_container || 
-                                                        has_ltlt || 
-                                                        has_reflect || 
-                                                        is_tuple );
-         };
+   /**
+    * @brief Call f(name, value) for every field of t registered with 
+    * CPPREFLECT_FIELDS, in order
+    */
+   template<typename T, typename F>
+      void forEachField(const T& t, F&& f)
+      {
+         const auto& fields = cppReflectFields(&t);
+         std::size_t i = 0;
+         std::apply([&](auto... member) { (..., f(fields.site.names[i++], t.*member)); }, 
+                    fields.members);
+      }
 
-      //------------------------------------------------------------------------
-      // Declaration
-      //------------------------------------------------------------------------
-      /**
-       * @brief print variable that has an API named reflect
-       */
-      template<typename T>
-         typename std::enable_if<stream_var<std::ostringstream, T>::has_reflect, void>::type
-         _processNameValue(std::ostringstream& oBuffer, const std::string& varT, const T& t);
+   /**
+    * @brief Advance over a string/char literal starting at str[i].
+    *
+    * @return index of the closing quote
+    */
+   constexpr std::size_t skipLiteral(const char* str, std::size_t i)
+   {
+      const char quote = str[i++];
+      while(str[i] && str[i] != quote)
+      {
+         if(str[i] == '\\' && str[i+1]) i++;
+         i++;
+      }
+      return i;
+   }
 
-      /**
-       * @brief print variable that has << operator defined
-       */
-      template<typename T>
-         typename std::enable_if<stream_var<std::ostringstream, T>::has_ltlt, void>::type
-         _processNameValue(std::ostringstream& oBuffer, const std::string& varT, const T& t);
+   /**
+    * @brief true if str[i] opens a string/char literal. A quote inside a 
+    * number (a token starting with a digit, like 1'000 or 0x7'ff) is a 
+    * digit separator, one after a prefix (L'a', u8'a') opens a literal.
+    */
+   constexpr bool startsLiteral(const char* str, std::size_t i)
+   {
+      if(str[i] == '"') return true;
+      if(str[i] != '\'') return false;
+      std::size_t start = i;
+      for(; start > 0; start--)
+      {
+         const char c = str[start - 1];
+         if(!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || 
+              c == '_' || c == '.' || c == '\'')) break;
+      }
+      if(str[start] == '.') start++;
+      return start == i || str[start] < '0' || str[start] > '9';
+   }
 
-      /**
-       * @brief print variable of tuple type - terminating condition function.
-       */
-      template<typename T, std::size_t N = 0>
-         typename std::enable_if< N == std::tuple_size<T>::value, void>::type
-         reflectTuple(std::ostringstream& oBuffer, const std::string& varT, const T& t);
+   /**
+    * @brief Count variables in "string" representation of macro arguments.
+    * Only top level commas separate variables, same as for the preprocessor.
+    */
+   constexpr std::size_t countNames(const char* str)
+   {
+      std::size_t count = 0, parens = 0;
+      bool empty = true;
+      for(std::size_t i = 0; str[i]; i++)
+      {
+         const char c = str[i];
+         if(startsLiteral(str, i)) i = skipLiteral(str, i);
+         else if(c == '(') parens++;
+         else if(c == ')') parens--;
+         else if(c == ',' && parens == 0) { count++; continue; }
+         if(c != ' ') empty = false;
+      }
+      return empty ? 0 : count + 1;
+   }
 
-      /**
-       * @brief print variable of tuple type - incrementally print next elements.
-       */
-      template<typename T, std::size_t N = 0>
-         typename std::enable_if< N < std::tuple_size<T>::value, void>::type
-         reflectTuple(std::ostringstream& oBuffer, const std::string& varT, const T& t);
+   /**
+    * @brief Split "string" representation of macro arguments into a table of
+    * N names, removing white-spaces outside of literals.
+    */
+   template<std::size_t N, std::size_t Len>
+      constexpr nameTable<Len, N> splitNames(const char (&str)[Len])
+      {
+         nameTable<Len, N> ret;
+         std::size_t pos = 0, name = 0, parens = 0;
+         for(std::size_t i = 0; i + 1 < Len && name < N; i++)
+         {
+            const char c = str[i];
+            if(c == ',' && parens == 0)
+            {
+               ret.len[name] = pos - ret.off[name];
+               if(++name < N) ret.off[name] = pos;
+               continue;
+            }
+            if(c == ' ' || c == '\t' || c == '\n') continue;
+            if(c == '(') parens++;
+            if(c == ')') parens--;
+            std::size_t end = i;
+            if(startsLiteral(str, i)) end = skipLiteral(str, i);
+            for(; i <= end && i + 1 < Len; i++) ret.buf[pos++] = str[i];
+            i--;
+         }
+         if(name < N) ret.len[name] = pos - ret.off[name];
+         return ret;
+      }
 
-      /**
-       * @brief print variable of tuple type 
-       */
-      template<typename T>
-         typename std::enable_if<stream_var<std::ostringstream, T>::is_tuple, void>::type
-         _processNameValue(std::ostringstream& oBuffer, const std::string& varT, const T& t);
+   /**
+    * @brief Sink wrapper to write reflection output into a fixed size char
+    * buffer. Output that doesn't fit is dropped and the buffer is always
+    * null terminated (when its size is non-zero).
+    */
+   struct charBuffer {
+      char* data;
+      std::size_t size;
+   };
 
-      /**
-       * @brief print container variable 
-       */
-      template<typename T>
-         typename std::enable_if<stream_var<std::ostringstream, T>::is_container, void>::type
-         _processNameValue(std::ostringstream& oBuffer, const std::string& varT, const T& t);
+   /**
+    * @brief Sink wrapper to write reflection output into a raw file descriptor.
+    */
+   struct fdSink {
+      int fd;
+   };
 
-      /**
-       * @brief If an unsupported variable is used, SFINAE will invoke this API.
-       */
-      template<typename T>
-         typename std::enable_if<stream_var<std::ostringstream, T>::not_printable, void>::type
-         _processNameValue(std::ostringstream& oBuffer, const std::string& varT, const T& t);
+   /**
+    * @brief Sink wrapper handing reflection output over to write(target, 
+    * data, len), in chunks of up to a few KB
+    */
+   struct callbackSink {
+      void* target;
+      void (*write)(void* target, const char* data, std::size_t len);
+   };
 
-      /**
-       * @brief terminating condition function when all variables are completed.
-       */
-      void _reflect(std::ostringstream& oBuffer, std::string nameStr);
+   /**
+    * @brief Traits of types the writer formats by itself (std::to_chars for
+    * numbers, plain copy for chars and strings) instead of going through
+    * their << operator.
+    *
+    * @tparam T datatype of the variable
+    */
+   template<typename T>
+      struct scalar_var {
+         static constexpr bool is_bool = std::is_same<T, bool>::value;
+         static constexpr bool is_char = ( std::is_same<T, char>::value ||
+                                           std::is_same<T, signed char>::value ||
+                                           std::is_same<T, unsigned char>::value );
+         static constexpr bool is_integer = ( std::is_integral<T>::value && 
+                                              !is_bool && !is_char &&
+                                              !std::is_same<T, wchar_t>::value &&
+                                              !std::is_same<T, char16_t>::value &&
+                                              !std::is_same<T, char32_t>::value );
+         static constexpr bool is_float = std::is_floating_point<T>::value;
+         static constexpr bool is_cstring = ( 
+            std::is_same<typename std::decay<T>::type, const char*>::value ||
+            std::is_same<typename std::decay<T>::type, char*>::value );
+         static constexpr bool is_string = ( std::is_same<T, std::string>::value ||
+                                             std::is_same<T, std::string_view>::value );
+         static constexpr bool value = ( is_bool || is_char || is_integer || 
+                                         is_float || is_cstring || is_string );
+      };
 
-      /**
-       * @brief Pick one variable and print it, call recursively to print all variables
-       */
-      template<typename T, typename... TRest>
-         void _reflect(std::ostringstream& oBuffer, std::string nameStr,
-                       const T& t, const TRest&... tRest);
+   /**
+    * @brief Characters of a string type of scalar_var (C string, char array,
+    * std::string or std::string_view)
+    */
+   template<typename T>
+      std::string_view stringOf(const T& t)
+      {
+         if constexpr (std::is_array<T>::value) 
+            return std::string_view(t, std::find(t, t + std::extent<T>::value, '\0') - t);
+         else if constexpr (scalar_var<T>::is_cstring) 
+            return t ? std::string_view(t) : std::string_view();
+         else return std::string_view(t.data(), t.size());
+      }
 
-      //------------------------------------------------------------------------
-      // Definition 
-      //------------------------------------------------------------------------
-      /**
-       * @brief print variable that has an API named reflect
-       */
-      template<typename T>
-         typename std::enable_if<stream_var<std::ostringstream, T>::has_reflect, void>::type
-         _processNameValue(std::ostringstream& oBuffer, 
-                           const std::string& varT, const T& t)
+   /**
+    * @brief Buffered writer used by the reflection engine to emit its output.
+    *
+    * Output is collected in a small buffer and handed over to the sink when
+    * the buffer is full or the writer is flushed/destroyed. For a charBuffer
+    * sink the caller's buffer is written in place.
+    */
+   class writer {
+      public:
+         explicit writer(std::ostream& os) 
+            : writer(&os, [](void* os_, const char* data, std::size_t len) { 
+                  static_cast<std::ostream*>(os_)->write(data, len); }) {}
+
+         explicit writer(std::string& str)
+            : writer(&str, [](void* str_, const char* data, std::size_t len) { 
+                  static_cast<std::string*>(str_)->append(data, len); }) {}
+
+         explicit writer(fdSink sink)
+            : writer(&fd_, [](void* fd_, const char* data, std::size_t len) { 
+                  writeFd(*static_cast<int*>(fd_), data, len); }) 
+         { fd_ = sink.fd; }
+
+         explicit writer(callbackSink sink) : writer(sink.target, sink.write) {}
+
+         explicit writer(charBuffer buf)
          {
-            oBuffer << beginDelim() << varT << " ( Object )" << endDelim() ;
-            oBuffer << t.reflect();
+            begin_ = cur_ = buf.data;
+            end_ = bufEnd_ = buf.size ? buf.data + buf.size - 1 : buf.data;
+            fixed_ = buf.size != 0;
          }
 
-      /**
-       * @brief print variable that has << operator defined
-       */
-      template<typename T>
-         typename std::enable_if<stream_var<std::ostringstream, T>::has_ltlt, void>::type
-         _processNameValue(std::ostringstream& oBuffer, 
-                           const std::string& varT, const T& t)
+         template<std::size_t Size>
+            explicit writer(char (&buf)[Size]) : writer(charBuffer{buf, Size}) {}
+
+         ~writer() 
          {
-            oBuffer << beginDelim() << varT << middleDelim() << t << endDelim() ;
+            flush();
+            if(fixed_) *cur_ = '\0';
          }
 
-      /**
-       * @brief print variable of tuple type - terminating condition function.
-       */
-      template<typename T, std::size_t N = 0>
-         typename std::enable_if< N == std::tuple_size<T>::value, void>::type
-         reflectTuple(std::ostringstream& oBuffer, 
-                      const std::string& varT, const T& t)
+         writer(const writer&) = delete;
+         writer& operator=(const writer&) = delete;
+
+         /**
+          * @brief Append len bytes from data
+          */
+         void write(const char* data, std::size_t len)
          {
-            (void) oBuffer; (void) varT; (void) t;
+            while(len > static_cast<std::size_t>(end_ - cur_))
+            {
+               std::size_t room = end_ - cur_;
+               std::memcpy(cur_, data, room);
+               cur_ += room; data += room; len -= room;
+               if(!drain()) return;
+            }
+            std::memcpy(cur_, data, len);
+            cur_ += len;
          }
 
-      /**
-       * @brief print variable of tuple type - incrementally print next elements.
-       */
-      template<typename T, std::size_t N = 0>
-         typename std::enable_if< N < std::tuple_size<T>::value, void>::type
-         reflectTuple(std::ostringstream& oBuffer, 
-                      const std::string& varT, const T& t)
+         /**
+          * @brief Append one character
+          */
+         void put(char c)
          {
-            // std::get has to have a const at compile time !!!!
-            // Iterating over tuple is an interesting problem
-            std::string varTElem = varT + "[" + std::to_string(N) + "]";
-            auto t_N = std::get<N>(t);
-            _processNameValue(oBuffer, varTElem, t_N); 
-            reflectTuple<T,N+1>(oBuffer, varT, t);
+            if(cur_ == end_ && !drain()) return;
+            *cur_++ = c;
          }
 
-      /**
-       * @brief print variable of tuple type 
-       */
-      template<typename T>
-         typename std::enable_if<stream_var<std::ostringstream, T>::is_tuple, void>::type
-         _processNameValue(std::ostringstream& oBuffer, 
-                           const std::string& varT, const T& t)
+         /**
+          * @brief Hand over buffered bytes to the sink
+          */
+         void flush()
          {
-            oBuffer << beginDelim() << varT << " ( Tuple with " 
-               << std::tuple_size<T>::value << " elements )" << endDelim() ;
-            incrDepth();
-            reflectTuple(oBuffer, varT, t);
-            decrDepth();
+            if(!flushFn_) return;
+            flushFn_(target_, begin_, cur_ - begin_);
+            flushed_ += cur_ - begin_;
+            cur_ = begin_;
+            clampEnd();
          }
 
-      /**
-       * @brief print container variable 
-       */
-      template<typename T>
-         typename std::enable_if<stream_var<std::ostringstream, T>::is_container, void>::type
-         _processNameValue(std::ostringstream& oBuffer, 
-                           const std::string& varT, const T& t)
-         {
-            oBuffer << beginDelim() << varT << " ( Container with " 
-               << t.size() << " elements )" << endDelim() ;
-            incrDepth();
-            int i = 0;
-            for(auto it = t.begin(); it != t.end(); it++)
-            {
-               std::string varTElem = varT + "[" + std::to_string(i) + "]";
-               _processNameValue(oBuffer, varTElem, (*it)); 
-               i++;
-            }
-            decrDepth();
+         /**
+          * @brief true if nothing more can be written (charBuffer sink is 
+          * full or size limit is reached)
+          */
+         bool full() const 
+         { 
+            return cur_ == end_ && (!flushFn_ || size() >= limit_); 
          }
 
-      /**
-       * @brief If an unsupported variable is used, SFINAE will invoke this API.
-       */
-      template<typename T>
-         typename std::enable_if<stream_var<std::ostringstream, T>::not_printable, void>::type
-         _processNameValue(std::ostringstream& oBuffer, 
-                           const std::string& varT, const T& t)
+         /**
+          * @brief Drop everything written once size() reaches maxSize (bytes
+          * written in total, including what was written before). Use
+          * noLimit to lift it again.
+          */
+         void limit(std::size_t maxSize)
          {
-            (void) t;
-            oBuffer << beginDelim() << varT <<" can't be printed. \n ";
+            limit_ = maxSize;
+            clampEnd();
          }
 
-      /**
-       * @brief terminating condition function when all variables are completed.
-       */
-      void _reflect(std::ostringstream& oBuffer,
-                    std::string nameStr)
-      {
-         // below statements are to avoid having compiler unused warnings
-         (void) oBuffer; (void) nameStr;
-         return;
-      }
+         static constexpr std::size_t noLimit = static_cast<std::size_t>(-1);
 
-      /**
-       * @brief Pick one variable and print it, call recursively to print all variables
-       */
-      template<typename T, typename... TRest>
-         void _reflect(std::ostringstream& oBuffer, 
-                       std::string nameStr,
-                       const T& t, const TRest&... tRest)
+         /**
+          * @brief Total number of bytes written so far (flushed or not)
+          */
+         std::size_t size() const { return flushed_ + (cur_ - begin_); }
+
+         /**
+          * @brief true if output was dropped as a charBuffer sink was full or
+          * the size limit was reached
+          */
+         bool truncated() const { return truncated_; }
+
+         /**
+          * @brief std::ostream writing into this writer, for types that are
+          * printed using their << operator.
+          */
+         std::ostream& stream()
          {
-            std::string varT = nameStr, varTRest = "", ret = "";
+            if(!os_)
+            {
+               // built on first use only, a streambuf constructs a std::locale
+               streamBuf_.emplace(*this);
+               os_.emplace(&*streamBuf_);
+               *os_ << std::boolalpha;
+            }
+            return *os_;
+         }
+
+         /**
+          * @brief Print a bool, char, number or string (see scalar_var) 
+          * without going through std::ostream.
+          */
+         template<typename T>
+            void writeScalar(const T& t)
+            {
+               typedef scalar_var<T> traits;
+               if constexpr (traits::is_bool) t ? write("true", 4) : write("false", 5);
+               else if constexpr (traits::is_char) put(static_cast<char>(t));
+               else if constexpr (traits::is_integer || traits::is_float) writeNumber(t);
+               else
+               {
+                  const std::string_view str = stringOf(t);
+                  write(str.data(), str.size());
+               }
+            }
 
-            auto pos = nameStr.find(',');
-            if(pos != std::string::npos)
+         /**
+          * @brief Print count numbers data[0], data[stride], ... separated by 
+          * sep. Numbers are formatted in batches straight into the buffer,
+          * without any per number bounds/limit checks.
+          */
+         template<typename T>
+            void writeNumbers(const T* data, std::size_t count, std::size_t stride,
+                              std::string_view sep)
             {
-               varT = nameStr.substr(0,pos);
-               varTRest = nameStr.substr(pos+1);
+               constexpr std::size_t maxLen = 32;
+               const std::size_t perNumber = maxLen + sep.size();
+               std::size_t i = 0;
+               while(i < count)
+               {
+                  std::size_t batch = static_cast<std::size_t>(end_ - cur_) / perNumber;
+                  if(batch == 0)
+                  {
+                     if(drainFor(perNumber)) continue;
+                     // close to a size limit/end of charBuffer, go slowly 
+                     for(; i < count && !full(); i++)
+                     {
+                        if(i) write(sep.data(), sep.size());
+                        writeNumber(data[i * stride]);
+                     }
+                     return;
+                  }
+                  batch = std::min(batch, count - i);
+                  char* p = cur_;
+                  for(const std::size_t last = i + batch; i < last; i++)
+                  {
+                     if(i) { std::memcpy(p, sep.data(), sep.size()); p += sep.size(); }
+                     p = std::to_chars(p, p + maxLen, data[i * stride]).ptr;
+                  }
+                  cur_ = p;
+               }
             }
 
-            varT.erase(std::remove(varT.begin(), varT.end(), ' '), varT.end());
+         /**
+          * @brief Write t as raw little-endian bytes
+          */
+         template<typename T>
+            void writeLittleEndian(T t)
+            {
+               char bytes[sizeof(T)];
+               std::memcpy(bytes, &t, sizeof(T));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+               std::reverse(bytes, bytes + sizeof(T));
+#endif
+               write(bytes, sizeof(T));
+            }
 
-            _processNameValue(oBuffer, varT, t);
-            _reflect(oBuffer, varTRest, tRest...);
+         /**
+          * @brief Write n as varint, 7 bits per byte, least significant first
+          */
+         void writeVarint(std::uint64_t n)
+         {
+            char bytes[10];
+            std::size_t len = 0;
+            for(; n >= 0x80; n >>= 7) bytes[len++] = static_cast<char>(n | 0x80);
+            bytes[len++] = static_cast<char>(n);
+            write(bytes, len);
          }
-   } // End of unnamed namespace
 
-   /**
-    * @brief reflect given list of variables.
-    *
-    * @param modeArg - mode set from macro
-    * @param nameStr - "string" representation of all variables passed to macro
+         /**
+          * @brief Number of bytes writeVarint(n) writes
+          */
+         static std::size_t varintSize(std::uint64_t n)
+         {
+            std::size_t len = 1;
+            for(; n >= 0x80; n >>= 7) len++;
+            return len;
+         }
+
+         /**
+          * @brief Write str as a quoted JSON string, escaping quotes, 
+          * backslashes and control characters. Runs of plain characters are
+          * copied in one go.
+          */
+         void writeJSONString(std::string_view str)
+         {
+            static const char hex[] = "0123456789abcdef";
+            put('"');
+            std::size_t run = 0;
+            for(std::size_t i = 0; i < str.size(); i++)
+            {
+               const unsigned char c = str[i];
+               if(c >= 0x20 && c != '"' && c != '\\') continue;
+               write(str.data() + run, i - run);
+               run = i + 1;
+               char esc[6] = { '\\', static_cast<char>(c), '0', '0', '0', '0' };
+               switch(c)
+               {
+                  case '\n': esc[1] = 'n'; break;
+                  case '\t': esc[1] = 't'; break;
+                  case '\r': esc[1] = 'r'; break;
+                  case '\b': esc[1] = 'b'; break;
+                  case '\f': esc[1] = 'f'; break;
+                  case '"': case '\\': break;
+                  default:
+                     esc[1] = 'u'; esc[4] = hex[c >> 4]; esc[5] = hex[c & 0xf];
+                     write(esc, 6);
+                     continue;
+               }
+               write(esc, 2);
+            }
+            write(str.data() + run, str.size() - run);
+            put('"');
+         }
+
+         /**
+          * @brief Print scalars (see scalar_var) directly, everything else via stream()
+          */
+         template<typename T>
+            writer& operator<<(const T& t)
+            {
+               if constexpr (scalar_var<T>::value) writeScalar(t);
+               else stream() << t;
+               return *this;
+            }
+
+      private:
+         typedef void (*flushFunc)(void* target, const char* data, std::size_t len);
+
+         /**
+          * @brief streambuf forwarding everything to the owning writer
+          */
+         class streamBuf : public std::streambuf {
+            public:
+               explicit streamBuf(writer& w) : w_(w) {}
+            protected:
+               int_type overflow(int_type c) override
+               {
+                  if(!traits_type::eq_int_type(c, traits_type::eof()))
+                     w_.put(traits_type::to_char_type(c));
+                  return traits_type::not_eof(c);
+               }
+               std::streamsize xsputn(const char* s, std::streamsize n) override
+               {
+                  w_.write(s, n);
+                  return n;
+               }
+            private:
+               writer& w_;
+         };
+
+         writer(void* target, flushFunc flushFn) : target_(target), flushFn_(flushFn)
+         {
+            begin_ = cur_ = local_;
+            end_ = bufEnd_ = local_ + sizeof(local_);
+         }
+
+         /**
+          * @brief Format number with std::to_chars (shortest round trip
+          * representation for floating points), in place when it fits.
+          */
+         template<typename T>
+            void writeNumber(T t)
+            {
+               constexpr std::ptrdiff_t maxLen = 64;
+               if(end_ - cur_ >= maxLen)
+               {
+                  auto res = std::to_chars(cur_, end_, t);
+                  if(res.ec == std::errc()) { cur_ = res.ptr; return; }
+               }
+               char tmp[maxLen];
+               auto res = std::to_chars(tmp, tmp + maxLen, t);
+               if(res.ec == std::errc()) write(tmp, res.ptr - tmp);
+               else stream() << t;
+            }
+
+         /**
+          * @brief Make room in a full buffer, false if nothing more fits
+          */
+         bool drain()
+         {
+            if(!flushFn_ || size() >= limit_)
+            {
+               truncated_ = true;
+               return false;
+            }
+            flush();
+            return true;
+         }
+
+         /**
+          * @brief Flush if that leaves room for len more bytes in the buffer
+          */
+         bool drainFor(std::size_t len)
+         {
+            if(!flushFn_ || size() + len > limit_ || 
+               len > static_cast<std::size_t>(bufEnd_ - begin_)) return false;
+            flush();
+            return true;
+         }
+
+         /**
+          * @brief Stop end_ at the size limit, so that write/put only have
+          * to check for a full buffer.
+          */
+         void clampEnd()
+         {
+            end_ = bufEnd_;
+            const std::size_t written = size();
+            const std::size_t left = limit_ > written ? limit_ - written : 0;
+            if(left < static_cast<std::size_t>(end_ - cur_)) end_ = cur_ + left;
+         }
+
+         /**
+          * @brief write(2) the whole data, retrying on partial writes/EINTR
+          */
+         static void writeFd(int fd, const char* data, std::size_t len)
+         {
+            while(len)
+            {
+#if defined(_WIN32)
+               auto ret = ::_write(fd, data, static_cast<unsigned int>(len));
+#else
+               auto ret = ::write(fd, data, len);
+#endif
+               if(ret < 0 && errno == EINTR) continue;
+               if(ret <= 0) return;
+               data += ret; len -= ret;
+            }
+         }
+
+         void* target_ = nullptr;
+         flushFunc flushFn_ = nullptr;
+         int fd_ = -1;
+         char* begin_ = nullptr;
+         char* cur_ = nullptr;
+         char* end_ = nullptr;
+         char* bufEnd_ = nullptr;
+         std::size_t limit_ = noLimit;
+         bool fixed_ = false;
+         bool truncated_ = false;
+         std::size_t flushed_ = 0;
+         std::optional<streamBuf> streamBuf_;
+         std::optional<std::ostream> os_;
+         char local_[4096];
+   };
+
+   class context;
+
+   /**
+    * @brief Statistics of one call site of the reflection macros, see 
+    * siteStatsSnapshot. Only top level reflections count, the time, bytes
+    * and elements of reflections nested into them (e.g. CppReflectTo(ctx, ...)
+    * of a 'reflect' API) are part of their parent's.
+    */
+   struct siteStats {
+      std::string file;
+      unsigned line = 0;
+      std::string variables;
+      std::uint64_t calls = 0;
+      std::uint64_t totalNanos = 0;
+      std::uint64_t maxNanos = 0;
+      std::uint64_t bytes = 0;
+      std::uint64_t elements = 0;
+      std::uint64_t truncations = 0;
+
+      void reflect(context& ctx) const;
+   };
+
+#if CPPREFLECT_INSTRUMENT
+   /**
+    * @brief Counters of one call site on one thread. Only the owning thread
+    * writes them, with relaxed loads and stores (no read-modify-write), 
+    * snapshots read them from any thread.
+    */
+   struct siteCounters {
+      std::atomic<std::uint64_t> calls{0};
+      std::atomic<std::uint64_t> totalNanos{0};
+      std::atomic<std::uint64_t> maxNanos{0};
+      std::atomic<std::uint64_t> bytes{0};
+      std::atomic<std::uint64_t> elements{0};
+      std::atomic<std::uint64_t> truncations{0};
+
+      static void bump(std::atomic<std::uint64_t>& counter, std::uint64_t n)
+      {
+         counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+      }
+
+      void clear()
+      {
+         for(auto* counter : { &calls, &totalNanos, &maxNanos, &bytes, &elements, &truncations })
+            counter->store(0, std::memory_order_relaxed);
+      }
+
+      void addTo(siteStats& stats) const
+      {
+         stats.calls += calls.load(std::memory_order_relaxed);
+         stats.totalNanos += totalNanos.load(std::memory_order_relaxed);
+         stats.maxNanos = std::max(stats.maxNanos, maxNanos.load(std::memory_order_relaxed));
+         stats.bytes += bytes.load(std::memory_order_relaxed);
+         stats.elements += elements.load(std::memory_order_relaxed);
+         stats.truncations += truncations.load(std::memory_order_relaxed);
+      }
+   };
+
+   /**
+    * @brief siteCounters of one thread, by call site id, in blocks that are
+    * allocated on first use and never move, so that snapshots can read them
+    * while the thread adds more.
+    */
+   class siteCounterTable {
+      public:
+         static constexpr std::size_t blockSize = 256;
+         static constexpr std::size_t maxBlocks = 256;
+
+         siteCounterTable() = default;
+         ~siteCounterTable()
+         {
+            for(auto& block : blocks_) delete[] block.load(std::memory_order_relaxed);
+         }
+
+         siteCounterTable(const siteCounterTable&) = delete;
+         siteCounterTable& operator=(const siteCounterTable&) = delete;
+
+         /**
+          * @brief Counters of call site id, nullptr if not used on this 
+          * thread (or beyond the maximal id)
+          */
+         const siteCounters* find(std::uint32_t id) const
+         {
+            if(id / blockSize >= maxBlocks) return nullptr;
+            const siteCounters* block = blocks_[id / blockSize].load(std::memory_order_acquire);
+            return block ? block + id % blockSize : nullptr;
+         }
+
+         /**
+          * @brief Counters of call site id, owning thread only
+          */
+         siteCounters* get(std::uint32_t id)
+         {
+            if(id / blockSize >= maxBlocks) return nullptr;
+            std::atomic<siteCounters*>& block = blocks_[id / blockSize];
+            siteCounters* counters = block.load(std::memory_order_relaxed);
+            if(!counters)
+            {
+               counters = new siteCounters[blockSize];
+               block.store(counters, std::memory_order_release);
+            }
+            return counters + id % blockSize;
+         }
+
+         void clear()
+         {
+            for(auto& block : blocks_)
+               if(siteCounters* counters = block.load(std::memory_order_relaxed))
+                  for(std::size_t i = 0; i < blockSize; i++) counters[i].clear();
+         }
+
+         /**
+          * @brief resetSiteStats epoch the counters belong to, counters of an
+          * older epoch are cleared by the owning thread on its next record
+          */
+         std::atomic<std::uint64_t> epoch{0};
+
+      private:
+         std::atomic<siteCounters*> blocks_[maxBlocks] = {};
+   };
+
+   /**
+    * @brief Process wide table of the call sites and of the per thread 
+    * counters, plus the counts of threads that exited.
+    */
+   struct siteRegistry {
+      std::mutex lock;
+      std::vector<callSiteState*> sites;
+      std::vector<const siteCounterTable*> threads;
+      std::vector<siteStats> exited;
+      std::atomic<std::uint64_t> epoch{1};
+
+      static siteRegistry& global()
+      {
+         // never destroyed, threads may still exit after static destruction
+         static siteRegistry* registry = new siteRegistry;
+         return *registry;
+      }
+   };
+
+   /**
+    * @brief Counters of the calling thread, plus running totals of elements
+    * visited and truncations
+    */
+   class threadSiteCounters {
+      public:
+         threadSiteCounters()
+         {
+            siteRegistry& registry = siteRegistry::global();
+            std::lock_guard<std::mutex> guard(registry.lock);
+            registry.threads.push_back(&table_);
+         }
+
+         ~threadSiteCounters()
+         {
+            siteRegistry& registry = siteRegistry::global();
+            std::lock_guard<std::mutex> guard(registry.lock);
+            registry.threads.erase(std::find(registry.threads.begin(), 
+                                             registry.threads.end(), &table_));
+            if(table_.epoch.load(std::memory_order_relaxed) != registry.epoch.load()) return;
+            registry.exited.resize(registry.sites.size());
+            for(std::size_t id = 0; id < registry.sites.size(); id++)
+               if(const siteCounters* counters = table_.find(static_cast<std::uint32_t>(id)))
+                  counters->addTo(registry.exited[id]);
+         }
+
+         static threadSiteCounters& get()
+         {
+            thread_local threadSiteCounters counters;
+            return counters;
+         }
+
+         /**
+          * @brief Counters of site on this thread, nullptr if it has too 
+          * high an id
+          */
+         siteCounters* of(callSiteState& site)
+         {
+            siteRegistry& registry = siteRegistry::global();
+            const std::uint64_t epoch = registry.epoch.load(std::memory_order_relaxed);
+            if(table_.epoch.load(std::memory_order_relaxed) != epoch)
+            {
+               table_.clear();
+               table_.epoch.store(epoch, std::memory_order_relaxed);
+            }
+            const std::uint32_t id = site.id();
+            if(!site.statsRegistered_.load(std::memory_order_relaxed) && 
+               !site.statsRegistered_.exchange(true))
+            {
+               std::lock_guard<std::mutex> guard(registry.lock);
+               if(registry.sites.size() <= id) registry.sites.resize(id + 1);
+               registry.sites[id] = &site;
+            }
+            return table_.get(id);
+         }
+
+         /**
+          * @brief Running totals of the thread, records take their share
+          * from (constant initialized, so counting costs no guard)
+          */
+         static std::uint64_t& elements()
+         {
+            thread_local std::uint64_t count = 0;
+            return count;
+         }
+
+         static std::uint64_t& truncations()
+         {
+            thread_local std::uint64_t count = 0;
+            return count;
+         }
+
+      private:
+         siteCounterTable table_;
+   };
+
+   /**
+    * @brief Measures one top level reflection of a call site, from its 
+    * construction to its destruction, and adds it to the site's counters
+    */
+   class siteTimer {
+      public:
+         siteTimer(callSiteState& site, const writer& out)
+            : site_(site), out_(out), counters_(threadSiteCounters::get()), 
+              bytes_(out.size()), elements_(threadSiteCounters::elements()), 
+              truncations_(threadSiteCounters::truncations()), truncatedBefore_(out.truncated()),
+              start_(std::chrono::steady_clock::now()) {}
+
+         ~siteTimer()
+         {
+            // output dropped by a full charBuffer sink
+            if(threadSiteCounters::truncations() == truncations_ && out_.truncated() && 
+               !truncatedBefore_) threadSiteCounters::truncations()++;
+            const std::uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - start_).count();
+            siteCounters* counters = counters_.of(site_);
+            if(!counters) return;
+            siteCounters::bump(counters->calls, 1);
+            siteCounters::bump(counters->totalNanos, nanos);
+            if(nanos > counters->maxNanos.load(std::memory_order_relaxed)) 
+               counters->maxNanos.store(nanos, std::memory_order_relaxed);
+            siteCounters::bump(counters->bytes, out_.size() - bytes_);
+            siteCounters::bump(counters->elements, threadSiteCounters::elements() - elements_);
+            siteCounters::bump(counters->truncations, 
+                               threadSiteCounters::truncations() - truncations_);
+         }
+
+         siteTimer(const siteTimer&) = delete;
+         siteTimer& operator=(const siteTimer&) = delete;
+
+      private:
+         callSiteState& site_;
+         const writer& out_;
+         threadSiteCounters& counters_;
+         const std::size_t bytes_;
+         const std::uint64_t elements_;
+         const std::uint64_t truncations_;
+         const bool truncatedBefore_;
+         const std::chrono::steady_clock::time_point start_;
+   };
+#endif
+
+   /**
+    * @brief Defines modes that can be used to change output of reflection
+    */
+   enum modeList { List=0, CSV, Binary, JSON, ModeCount};
+
+   /**
+    * @brief Tags of the Binary mode encoding. Every value is a tag followed by
+    * its payload, integers are little-endian, sizes/counts/ids are varints
+    * (7 bits per byte, least significant first).
+    *
+    * Stream items:
+    *   TagSiteDef id count (len name)*   - names of a call site, sent once per
+    *                                       call site into sinks (see 
+    *                                       resetBinaryNames), with every
+    *                                       record returned as a string or 
+    *                                       written to a ringFile
+    *   TagRecord u32-length body         - one top level reflection, body is
+    *                                       [TagSiteDef...] TagCall
+    *   TagRecordPart u32-length bytes    - leading part of the body of the
+    *                                       next TagRecord, long records are
+    *                                       written in parts of at least 
+    *                                       recordChunkBytes
+    *   TagTruncated maxBytes             - previous record was cut at maxBytes
+    *   TagSiteRef u64-address            - in place of TagSiteDef in the
+    *                                       captures of asyncQueue, which 
+    *                                       never leave the process: address
+    *                                       of the static call site whose 
+    *                                       names the decoder looks up
+    * Values:
+    *   TagCall id count value*           - variables of one macro call
+    *   TagBool/TagChar u8, TagInt8..TagUInt64/TagFloat/TagDouble raw bytes
+    *   TagString/TagText len bytes       - strings / types printed via <<
+    *   TagContainer size item* TagEnd    - items are values, TagSkip n (marker
+    *   TagTuple size item* TagEnd          of n not printed elements) or TagGap
+    *                                       n (n elements left out silently)
+    *   TagObject item* TagEnd            - items are TagSiteDef/Ref, TagCall,
+    *                                       TagRecord, TagHidden (members not
+    *                                       shown) or TagString (text output 
+    *                                       of a string returning reflect())
+    *   TagRange item* TagEnd count       - container without size(), its
+    *                                       count of printed elements comes 
+    *                                       last, TagMore before TagEnd if it
+    *                                       had more than maxElements
+    *   TagNumberArray elemTag count raw  - contiguous container of numbers
+    *   TagNotPrintable
+    *   TagRemoved                        - element removed since the previous
+    *                                       diff (see snapshot), diffs are 
+    *                                       records of call site 0 whose names
+    *                                       are the paths of the elements
+    *   TagPointer id value               - object reached through a pointer 
+    *                                       the first time (see 
+    *                                       options::followPointers)
+    *   TagPointerRef id                  - same object reached again
+    *   TagNull                           - null pointer
+    */
+   enum binaryTag : unsigned char {
+      TagSiteDef = 0x01, TagRecord, TagTruncated, TagCall, TagRecordPart, TagSiteRef,
+      TagBool = 0x10, TagChar, TagInt8, TagInt16, TagInt32, TagInt64, 
+      TagUInt8, TagUInt16, TagUInt32, TagUInt64, TagFloat, TagDouble,
+      TagString, TagText,
+      TagContainer = 0x30, TagTuple, TagObject, TagNumberArray, TagEnd,
+      TagSkip, TagGap, TagHidden, TagNotPrintable, TagRemoved,
+      TagPointer, TagPointerRef, TagNull, TagRange, TagMore
+   };
+
+   /**
+    * @brief Binary records are length prefixed, hence encoded aside before
+    * being written, in parts of this size once they get longer, so that
+    * reflecting a long range takes constant memory
+    */
+   constexpr std::size_t recordChunkBytes = 1 << 16;
+
+   /**
+    * @brief Options controlling the output of reflection. Nested reflections
+    * use the options of the reflection enclosing them, others the options
+    * of the innermost options::scope of their thread, else defaults().
+    */
+   struct options {
+      /**
+       * @brief Print bools, chars, numbers and strings with their << operator,
+       * like before the writer formatted them itself (default precision of 6
+       * digits for floating points instead of shortest round trip, honours
+       * the locale). Much slower.
+       */
+      bool streamScalars = false;
+
+      static constexpr std::size_t unlimited = static_cast<std::size_t>(-1);
+
+      /**
+       * @brief Defines which elements of a container are printed when it
+       * has more than maxElements elements.
+       */
+      enum samplingList { Head = 0, // first maxElements elements
+                          HeadTail, // first and last maxElements/2 elements
+                          Stride    // every (size/maxElements)th element
+                        };
+
+      /**
+       * @brief Maximum number of elements printed per container, the rest
+       * is summarized by a "... (N more elements)" line.
+       */
+      std::size_t maxElements = unlimited;
+
+      /**
+       * @brief Elements to print when a container has more than maxElements.
+       */
+      samplingList sampling = Head;
+
+      /**
+       * @brief Maximum depth of printed elements (variables passed to the
+       * macros are at depth 0). Deeper elements are summarized by a 
+       * "... (N more elements)" line.
+       */
+      std::size_t maxDepth = unlimited;
+
+      /**
+       * @brief Maximum number of bytes one reflection writes. Once reached
+       * the output is cut, the rest of the variables are not even visited
+       * and a "... (output truncated at N bytes)" line is added.
+       */
+      std::size_t maxBytes = unlimited;
+
+      /**
+       * @brief Print contiguous containers of numbers (std::vector<int>,
+       * std::array<float, N>, ...) on one line, e.g. "var5 = [3, 5, 7]",
+       * instead of one line per element.
+       */
+      bool compactArrays = false;
+
+      /**
+       * @brief Binary mode: send the names of the call sites with every
+       * record instead of once per binaryNamesEpoch, so that every record
+       * can be decoded on its own (e.g. when records may be reordered or 
+       * dropped). Always set for records returned as 
+       * strings or written to a ringFile.
+       */
+      bool binaryNamesPerRecord = false;
+
+      /**
+       * @brief Print what raw pointers, std::unique_ptr and std::shared_ptr
+       * point to instead of their address. Every object reached is given an
+       * id and printed once per reflection, pointers reaching it again only
+       * print its id, so shared nodes of a graph are not printed over and 
+       * over and cycles end.
+       */
+      bool followPointers = false;
+
+      /**
+       * @brief Format containers of at least parallelMinElements elements 
+       * on up to parallelThreads threads (the reflecting one included), in
+       * chunks concatenated in order: the output is the same as a serial
+       * reflection. 0 or 1 formats everything on the reflecting thread.
+       * Only applies to containers printed in full, when neither maxBytes
+       * nor followPointers is set and, in Binary mode, to elements without
+       * classes with a 'reflect' API unless binaryNamesPerRecord is set.
+       */
+      std::size_t parallelThreads = 0;
+      std::size_t parallelMinElements = 1 << 16;
+
+      /**
+       * @brief Options used by reflections that are not given any. 
+       * Meant to be set up once at start-up, before reflecting anything.
+       */
+      static options& defaults()
+      {
+         static options opts;
+         return opts;
+      }
+
+      /**
+       * @brief Makes opts the options of every reflection started on this
+       * thread while the scope is alive, e.g. to set limits for one call site.
+       */
+      class scope {
+         public:
+            explicit scope(const options& opts) : outer_(active()) { active() = &opts; }
+            ~scope() { active() = outer_; }
+
+            scope(const scope&) = delete;
+            scope& operator=(const scope&) = delete;
+
+            /**
+             * @brief Options of the innermost scope of this thread (nullptr if none)
+             */
+            static const options*& active()
+            {
+               thread_local const options* opts = nullptr;
+               return opts;
+            }
+
+         private:
+            const options* const outer_;
+      };
+
+      /**
+       * @brief Options of the innermost scope of this thread, else defaults()
+       */
+      static const options& current()
+      {
+         return scope::active() ? *scope::active() : defaults();
+      }
+   };
+
+   /**
+    * @brief Decides which calls of a call site are reflected, for the 
+    * CppReflectEveryN/FirstN/PerSecond macros. Lock free: a suppressed call
+    * costs one atomic increment (EveryN) or load (FirstN, PerSecond once 
+    * the quota of the second is used up) plus, for PerSecond, a read of a
+    * coarse monotonic clock. Safe to share between threads; PerSecond may let a few
+    * more calls through at the start of a second when threads race to 
+    * start it.
+    */
+   class sampler {
+      public:
+         bool everyN(std::uint64_t n)
+         {
+            return n && calls_.fetch_add(1, std::memory_order_relaxed) % n == 0;
+         }
+
+         bool firstN(std::uint64_t n)
+         {
+            // plain load first, so suppressed calls don't write the counter
+            return calls_.load(std::memory_order_relaxed) < n &&
+                   calls_.fetch_add(1, std::memory_order_relaxed) < n;
+         }
+
+         bool perSecond(std::uint64_t n)
+         {
+            const std::int64_t now = coarseNow();
+            std::int64_t start = secondStart_.load(std::memory_order_relaxed);
+            if(now - start >= 1000000000 && 
+               secondStart_.compare_exchange_strong(start, now, std::memory_order_relaxed))
+               calls_.store(0, std::memory_order_relaxed);
+            return firstN(n);
+         }
+
+      private:
+         /**
+          * @brief Monotonic time in ns, a few ms precision is plenty here
+          * and the coarse clock of Linux is several times cheaper to read
+          */
+         static std::int64_t coarseNow()
+         {
+#if defined(CLOCK_MONOTONIC_COARSE)
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+            return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+         }
+
+         std::atomic<std::uint64_t> calls_{0};
+         std::atomic<std::int64_t> secondStart_{std::numeric_limits<std::int64_t>::min() / 2};
+   };
+
+   /**
+    * @brief Verbosity levels of the CppReflectTrace/Debug/Info macros
+    */
+   enum levelList { Trace = CPPREFLECT_LEVEL_TRACE, Debug = CPPREFLECT_LEVEL_DEBUG, 
+                    Info = CPPREFLECT_LEVEL_INFO, Off = CPPREFLECT_LEVEL_OFF };
+
+   /**
+    * @brief Lowest level reflected at run time, among the levels compiled
+    * in (CPPREFLECT_MIN_LEVEL and above, all of them by default)
+    */
+   inline std::atomic<int>& runtimeLevel()
+   {
+      static std::atomic<int> level(CPPREFLECT_MIN_LEVEL);
+      return level;
+   }
+
+   /**
+    * @brief Reflect call sites of level and above only, from any thread
+    */
+   inline void setLevel(levelList level) 
+   { 
+      runtimeLevel().store(level, std::memory_order_relaxed); 
+   }
+
+   inline bool levelEnabled(levelList level)
+   {
+      return level >= runtimeLevel().load(std::memory_order_relaxed);
+   }
+
+   /**
+    * @brief Result of a call suppressed by a sampler or a level, converts
+    * to the default value of whatever the reflection would have returned
+    */
+   struct suppressed {
+      template<typename T>
+         operator T() const { return T(); }
+   };
+
+   /**
+    * @brief Growable buffer holding the name of the element being reflected
+    * (e.g. var10[0][1]). Names/indices are pushed while descending into
+    * containers and tuples and popped on the way back, so building the name
+    * of an element costs the same at any depth and needs no allocations
+    * once the buffer has grown to the deepest name.
+    */
+   class pathBuffer {
+      public:
+         /**
+          * @brief Append name, return mark to pop it later
+          */
+         std::size_t push(std::string_view name)
+         {
+            const std::size_t mark = buf_.size();
+            buf_.append(name.data(), name.size());
+            return mark;
+         }
+
+         /**
+          * @brief Append "[idx]", return mark to pop it later
+          */
+         std::size_t pushIndex(std::size_t idx)
+         {
+            char tmp[24];
+            tmp[0] = '[';
+            char* end = std::to_chars(tmp + 1, tmp + sizeof(tmp) - 1, idx).ptr;
+            *end++ = ']';
+            return push(std::string_view(tmp, end - tmp));
+         }
+
+         /**
+          * @brief Remove everything appended after mark was taken
+          */
+         void pop(std::size_t mark) { buf_.resize(mark); }
+
+         std::size_t size() const { return buf_.size(); }
+
+         std::string_view view(std::size_t from) const 
+         { return std::string_view(buf_).substr(from); }
+
+      private:
+         std::string buf_;
+   };
+
+   /**
+    * @brief Lease of a per thread buffer, reused across calls so that 
+    * reflecting the same shapes again doesn't allocate. Leases nest (a 
+    * reflection can run inside another one), every level has its own 
+    * buffer. The buffer is empty when leased.
+    */
+   class scratchBuffer {
+      public:
+         scratchBuffer() : buf_(acquire()) { buf_.clear(); }
+
+         ~scratchBuffer()
+         {
+            // don't keep one-off huge buffers alive for the thread lifetime
+            if(buf_.capacity() > maxRetained) std::string().swap(buf_);
+            pool().inUse--;
+         }
+
+         scratchBuffer(const scratchBuffer&) = delete;
+         scratchBuffer& operator=(const scratchBuffer&) = delete;
+
+         std::string& str() { return buf_; }
+
+      private:
+         static constexpr std::size_t maxRetained = 1 << 20;
+
+         struct bufferPool {
+            std::vector<std::unique_ptr<std::string>> buffers;
+            std::size_t inUse = 0;
+         };
+
+         static bufferPool& pool()
+         {
+            thread_local bufferPool buffers;
+            return buffers;
+         }
+
+         static std::string& acquire()
+         {
+            bufferPool& p = pool();
+            if(p.inUse == p.buffers.size()) p.buffers.emplace_back(new std::string);
+            return *p.buffers[p.inUse++];
+         }
+
+         std::string& buf_;
+   };
+
+   /**
+    * @brief Small pool of threads formatting chunks of large containers in
+    * parallel (see options::parallelThreads). The chunks of a job are 
+    * claimed one at a time from a shared counter by the pool threads and 
+    * the calling thread, so threads done early take over the chunks left.
+    * One job runs at a time, a reflection finding the pool busy (or running
+    * on a pool thread) formats its container itself. An exception thrown
+    * while formatting a chunk ends the job and is rethrown on the calling 
+    * thread, once no pool thread uses the job anymore.
+    */
+   class formatPool {
+      public:
+         static formatPool& global()
+         {
+            static formatPool pool;
+            return pool;
+         }
+
+         ~formatPool()
+         {
+            {
+               std::lock_guard<std::mutex> lock(mutex_);
+               stop_ = true;
+            }
+            wake_.notify_all();
+            for(std::thread& t : threads_) t.join();
+         }
+
+         /**
+          * @brief Claim the pool for a job, false if it is busy or if called
+          * from one of its threads
+          */
+         bool claim() 
+         { 
+            return !onPoolThread() && !busy_.exchange(true, std::memory_order_acquire); 
+         }
+
+         void unclaim() { busy_.store(false, std::memory_order_release); }
+
+         /**
+          * @brief Claim of the pool (see claim()), released when it goes out
+          * of scope
+          */
+         class claimScope {
+            public:
+               explicit claimScope(formatPool& pool) : pool_(pool), claimed_(pool.claim()) {}
+               ~claimScope() { if(claimed_) pool_.unclaim(); }
+
+               claimScope(const claimScope&) = delete;
+               claimScope& operator=(const claimScope&) = delete;
+
+               explicit operator bool() const { return claimed_; }
+
+            private:
+               formatPool& pool_;
+               const bool claimed_;
+         };
+
+         /**
+          * @brief Call fn(arg, i) for every chunk i in [0, chunks) on up to
+          * threads threads, the calling one included. The pool must be 
+          * claimed. Rethrows the first exception thrown by fn.
+          */
+         void run(std::size_t threads, std::size_t chunks, 
+                  void (*fn)(void* arg, std::size_t chunk), void* arg)
+         {
+            {
+               std::lock_guard<std::mutex> lock(mutex_);
+               while(threads_.size() + 1 < threads) threads_.emplace_back([this]() { work(); });
+               fn_ = fn;
+               arg_ = arg;
+               chunks_ = chunks;
+               next_.store(0, std::memory_order_relaxed);
+               helpers_ = threads - 1;
+               error_ = nullptr;
+            }
+            wake_.notify_all();
+            runChunks();
+            // every chunk is claimed, wait for the ones still being formatted
+            std::unique_lock<std::mutex> lock(mutex_);
+            helpers_ = 0;
+            finished_.wait(lock, [this]() { return active_ == 0; });
+            if(error_) std::rethrow_exception(std::exchange(error_, nullptr));
+         }
+
+         /**
+          * @brief Output buffers of the chunks of a job, kept for the next
+          * one. Only for the thread that claimed the pool.
+          */
+         std::vector<std::string>& buffers() { return buffers_; }
+
+      private:
+         static bool& onPoolThread()
+         {
+            thread_local bool onPool = false;
+            return onPool;
+         }
+
+         void runChunks()
+         {
+            try
+            {
+               for(std::size_t i; (i = next_.fetch_add(1, std::memory_order_relaxed)) < chunks_; )
+                  fn_(arg_, i);
+            }
+            catch(...)
+            {
+               // the chunks left are not formatted anymore
+               next_.store(chunks_, std::memory_order_relaxed);
+               std::lock_guard<std::mutex> lock(mutex_);
+               if(!error_) error_ = std::current_exception();
+            }
+         }
+
+         void work()
+         {
+            onPoolThread() = true;
+            std::unique_lock<std::mutex> lock(mutex_);
+            for(;;)
+            {
+               wake_.wait(lock, [this]() { return helpers_ > 0 || stop_; });
+               if(stop_) return;
+               helpers_--;
+               active_++;
+               lock.unlock();
+               runChunks();
+               lock.lock();
+               if(--active_ == 0) finished_.notify_all();
+            }
+         }
+
+         std::atomic<bool> busy_{false}; // claimed for a job
+         std::mutex mutex_;
+         std::condition_variable wake_, finished_;
+         std::vector<std::thread> threads_;
+         std::vector<std::string> buffers_;
+         void (*fn_)(void*, std::size_t) = nullptr;
+         void* arg_ = nullptr;
+         std::size_t chunks_ = 0;
+         std::atomic<std::size_t> next_{0};
+         std::size_t helpers_ = 0; // pool threads still to join the job
+         std::size_t active_ = 0; // pool threads running chunks
+         std::exception_ptr error_; // first exception of the job
+         bool stop_ = false;
+   };
+
+   class snapshot;
+
+   /**
+    * @brief Ids of the objects reached through pointers by one reflection
+    * (see options::followPointers): a flat open addressing table of 
+    * addresses and types (an object and its first member share their 
+    * address), per thread and reused across reflections. Entries are 
+    * stamped with the reflection they belong to, so starting a new one 
+    * doesn't wipe the table.
+    */
+   class pointerIds {
+      public:
+         /**
+          * @brief Table of this thread, emptied
+          */
+         static pointerIds& restart()
+         {
+            thread_local pointerIds ids;
+            if(++ids.generation_ == 0)
+            {
+               std::fill(ids.slots_.begin(), ids.slots_.end(), slot());
+               ids.generation_ = 1;
+            }
+            ids.count_ = 0;
+            return ids;
+         }
+
+         /**
+          * @brief Key of type T, unique per type across translation units
+          */
+         template<typename T>
+            static const void* typeKey()
+            {
+               static const char key = 0;
+               return &key;
+            }
+
+         /**
+          * @brief Id of the object of type T at address, given the next id 
+          * (and added set) if it was not reached yet
+          */
+         template<typename T>
+            std::size_t idOf(const T* address, bool& added)
+            {
+               return idOf(address, typeKey<std::remove_cv_t<T>>(), added);
+            }
+
+         std::size_t idOf(const void* address, const void* type, bool& added)
+         {
+            if(2 * (count_ + 1) > slots_.size()) grow();
+            slot& s = find(address, type);
+            added = s.generation != generation_;
+            if(added)
+            {
+               s = slot{address, type, generation_, ++count_};
+            }
+            return s.id;
+         }
+
+      private:
+         struct slot {
+            const void* address = nullptr;
+            const void* type = nullptr;
+            std::uint32_t generation = 0;
+            std::size_t id = 0;
+         };
+
+         slot& find(const void* address, const void* type)
+         {
+            const std::size_t mask = slots_.size() - 1;
+            const std::uintptr_t key = reinterpret_cast<std::uintptr_t>(address) >> 4 
+                                       ^ reinterpret_cast<std::uintptr_t>(type);
+            std::size_t i = key * 0x9e3779b97f4a7c15ull >> 32 & mask;
+            while(slots_[i].generation == generation_ && 
+                  (slots_[i].address != address || slots_[i].type != type)) 
+               i = (i + 1) & mask;
+            return slots_[i];
+         }
+
+         void grow()
+         {
+            std::vector<slot> old(std::max<std::size_t>(64, 2 * slots_.size()));
+            old.swap(slots_);
+            for(const slot& s : old)
+               if(s.generation == generation_) find(s.address, s.type) = s;
+         }
+
+         std::vector<slot> slots_;
+         std::uint32_t generation_ = 0;
+         std::size_t count_ = 0;
+   };
+
+   /**
+    * @brief Per call reflection state (writer, mode, depth, options and element names).
+    *
+    * A context is created by every reflect call and passed down to every
+    * helper, so concurrent reflections on different threads never share any
+    * state. While it is alive the context is also registered as the current
+    * context of its thread, which lets string returning 'reflect' APIs of
+    * nested objects (that use CppReflect) inherit mode and depth of the
+    * parent reflection. Classes can define 
+    * 'void reflect(CppReflection::context& ctx) const' and call 
+    * CppReflectTo(ctx, ...) to continue the parent reflection in place.
+    */
+   class context {
+      public:
+         context(writer& outArg, modeList modeArg, int depthArg, pathBuffer* pathArg = nullptr)
+            : out(outArg), mode(modeArg), depth(depthArg),
+              opts(current() ? current()->opts : options::current()),
+              path(pathArg ? *pathArg : current() ? current()->path : threadPath()), 
+              outer_(current()), pathBase_(path.size())
+         {
+            // objects reached through pointers are numbered per outermost 
+            // reflection
+            pointers = outer_ ? outer_->pointers : 
+                       opts.followPointers ? &pointerIds::restart() : nullptr;
+            current() = this;
+            lastMode() = modeArg;
+         }
+
+         ~context() { current() = outer_; }
+
+         /**
+          * @brief Path of the outermost context of this thread, reused 
+          * across reflections
+          */
+         static pathBuffer& threadPath()
+         {
+            thread_local pathBuffer path;
+            return path;
+         }
+
+         context(const context&) = delete;
+         context& operator=(const context&) = delete;
+
+         /**
+          * @brief Innermost context alive on this thread (nullptr if none)
+          */
+         static context*& current() 
+         { 
+            thread_local context* ctx = nullptr; 
+            return ctx; 
+         }
+
+         /**
+          * @brief Mode used by the last reflection started on this thread
+          */
+         static modeList& lastMode()
+         {
+            thread_local modeList mode = List;
+            return mode;
+         }
+
+         /**
+          * @brief Mode to be used by CppReflect/CppReflectTo: mode of the 
+          * current context, else the mode that was set by last *As* macros.
+          */
+         static modeList currentMode()
+         {
+            return current() ? current()->mode : lastMode();
+         }
+
+         /**
+          * @brief Depth at which a new reflection should start on this thread
+          * (nested reflections print at the depth of the members of the 
+          * object being reflected).
+          */
+         static int nextDepth()
+         {
+            return current() ? current()->depth : 0;
+         }
+
+         /**
+          * @brief Name of the element being reflected
+          */
+         std::string_view name() const { return path.view(pathBase_); }
+
+         writer& out;
+         modeList mode;
+         int depth;
+         const options& opts;
+         pathBuffer& path; // shared with the outer contexts of this thread
+         std::string_view key; // JSON: key of the next value, empty in arrays
+         bool separate = false; // JSON: next value at this level needs a ','
+         snapshot* diff = nullptr; // snapshot of the diff in progress, if any
+         pointerIds* pointers = nullptr; // set if pointers are followed
+
+      private:
+         context* const outer_;
+         const std::size_t pathBase_;
+   };
+
+   /**
+    * @brief State of diff reflections (see CppReflectDiff/CppReflectDiffTo):
+    * a hash of every element reflected through the snapshot, keyed by its 
+    * path (e.g. var5[3] or var7.a for member a of an object), plus the 
+    * hashes of the elements of containers. A diff prints, in the mode of
+    * the snapshot, only the elements added or modified since the previous
+    * diff through the same snapshot, one per line and named by their path,
+    * and the elements that were removed. Containers, tuples and objects 
+    * whose hash didn't change are skipped as a whole, so are elements of a
+    * changed container whose hash didn't change.
+    *
+    * Options other than maxBytes don't apply to diffs, every element is
+    * compared and pointers are compared by address. Objects with a string returning 'reflect' API are compared 
+    * and printed as one element. A snapshot must not be used by two threads
+    * at the same time.
+    */
+   class snapshot {
+      public:
+         explicit snapshot(modeList modeArg = List) : mode_(modeArg) {}
+
+         snapshot(const snapshot&) = delete;
+         snapshot& operator=(const snapshot&) = delete;
+
+         modeList mode() const { return mode_; }
+
+         /**
+          * @brief Forget every element, the next diff prints all of them
+          */
+         void clear() 
+         { 
+            elements_.clear(); 
+            roots_.clear(); 
+            forgotten_.clear();
+         }
+
+         /**
+          * @brief Number of elements remembered (containers, tuples and
+          * objects included)
+          */
+         std::size_t size() const { return elements_.size(); }
+
+         /**
+          * @brief What is remembered of an element: the hash of its value
+          * and, for containers, the hashes of their elements
+          */
+         struct element {
+            std::uint64_t hash = 0;
+            std::vector<std::uint64_t> children;
+         };
+
+         /**
+          * @brief Element at path, added (and added set) if not known yet
+          */
+         element& track(std::string_view path, bool& added)
+         {
+            key_.assign(path.data(), path.size());
+            auto it = elements_.find(key_);
+            added = it == elements_.end();
+            if(added) it = elements_.emplace(key_, element()).first;
+            return it->second;
+         }
+
+         /**
+          * @brief Forget the element at path and every element below it, at
+          * the next sweep()
+          */
+         void forget(std::string_view path) { forgotten_.emplace_back(path); }
+
+         /**
+          * @brief Forget what forget() was called for, in one pass over all
+          * the elements
+          */
+         void sweep()
+         {
+            if(forgotten_.empty()) return;
+            std::sort(forgotten_.begin(), forgotten_.end());
+            for(auto it = elements_.begin(); it != elements_.end(); )
+            {
+               // the element or one of the elements above it was forgotten
+               const std::string& path = it->first;
+               bool forgotten = false;
+               for(std::size_t end = 1; !forgotten && end <= path.size(); end++)
+                  if(end == path.size() || path[end] == '[' || path[end] == '.')
+                     forgotten = std::binary_search(forgotten_.begin(), forgotten_.end(), 
+                                                    std::string_view(path).substr(0, end));
+               it = forgotten ? elements_.erase(it) : std::next(it);
+            }
+            forgotten_.clear();
+         }
+
+         /**
+          * @brief Make names the variables of the snapshot, removed(name) is
+          * called for each variable of the previous diff not among them
+          */
+         template<typename F>
+            void updateRoots(const nameList& names, F removed)
+            {
+               bool same = roots_.size() == names.size();
+               for(std::size_t i = 0; same && i < names.size(); i++) same = roots_[i] == names[i];
+               if(same) return;
+               for(const std::string& root : roots_)
+               {
+                  bool kept = false;
+                  for(std::size_t i = 0; !kept && i < names.size(); i++) kept = root == names[i];
+                  if(!kept) removed(std::string_view(root));
+               }
+               roots_.assign(names.size(), std::string());
+               for(std::size_t i = 0; i < names.size(); i++) roots_[i] = names[i];
+            }
+
+         /**
+          * @brief Binary mode: add the path of a changed element to the 
+          * names of the diff in progress
+          */
+         void addBinaryName(std::string_view path)
+         {
+            binaryNames->writeVarint(path.size());
+            binaryNames->write(path.data(), path.size());
+            changes++;
+         }
+
+         /**
+          * @brief Hash of an element with no value of its own to hash (not a
+          * number or a string) and number of records of its sub-elements,
+          * which follow it
+          */
+         struct record {
+            std::uint64_t hash = 0;
+            std::size_t below = 0;
+         };
+
+         // state of the diff in progress, a first pass hashes every element
+         // into records (in the order they are visited), a second one
+         // compares them with the elements, skipping unchanged sub-trees
+         bool hashing = false;
+         std::vector<record> records;
+         std::vector<std::uint64_t> open; // hashes of the elements being hashed
+         std::size_t cursor = 0; // next record to compare
+         std::size_t pathBase = 0; // paths are in context::path from here
+         writer* binaryNames = nullptr; // Binary mode: names of the changes
+         std::size_t changes = 0; // Binary mode: number of changes
+
+      private:
+         modeList mode_;
+         std::unordered_map<std::string, element> elements_;
+         std::vector<std::string> roots_;
+         std::vector<std::string> forgotten_;
+         std::string key_; // lookup key, reused
+   };
+
+   /**
+    * @brief Unnamed namespace to hide all the helper struct/variable/functions from outside.
+    */
+   namespace { 
+
+      /**
+       * @brief typedef to define delimiters depending on mode.
+       */
+      typedef std::array<std::string_view, ModeCount> delimList;
+
+      /**
+       * @brief Delimiter to be printed before variable-value pair, the 
+       * indentation of the current depth. Served from a per thread string of
+       * tabs, grown when a deeper level shows up.
+       *
+       * @return delimiter string
+       */
+      auto beginDelim = [](const context& ctx){ 
+         if(ctx.mode != List || ctx.depth <= 0) return std::string_view();
+         thread_local std::string tabs(16, '\t');
+         const std::size_t depth = static_cast<std::size_t>(ctx.depth);
+         if(tabs.size() < depth) tabs.assign(2 * depth, '\t');
+         return std::string_view(tabs).substr(0, depth);};
+
+      /**
+       * @brief Delimiter to be printed between variable-value pair.
+       *
+       * @return delimiter string
+       */
+      auto middleDelim = [](const context& ctx){ 
+         static constexpr delimList delims = { " = ", " , " };
+         return delims.at(ctx.mode);};
+
+      /**
+       * @brief Delimiter to be printed after variable-value pair.
+       *
+       * @return delimiter string
+       */
+      auto endDelim = [](const context& ctx){ 
+         static constexpr delimList delims = { "\n", " , " };
+         return delims.at(ctx.mode);};
+
+      /**
+       * @brief true if the current depth is beyond options::maxDepth
+       */
+      auto beyondMaxDepth = [](const context& ctx){
+         return ctx.depth > 0 && static_cast<std::size_t>(ctx.depth) > ctx.opts.maxDepth;};
+
+      /**
+       * @brief Kinds of variables that have sub-variables
+       */
+      enum nodeKind { ContainerNode = 0, TupleNode, ObjectNode, RangeNode };
+
+      /**
+       * @brief JSON: ',' and key (for variables of a macro call) in front of 
+       * the next value
+       */
+      auto beginJSONValue = [](context& ctx){
+         if(ctx.separate) ctx.out.put(',');
+         ctx.separate = true;
+         if(ctx.key.empty()) return;
+         ctx.out.writeJSONString(ctx.key);
+         ctx.out.put(':');
+         ctx.key = std::string_view();};
+
+      /**
+       * @brief Print header of a variable with size sub-variables and go one
+       * level deeper
+       */
+      auto openNode = [](context& ctx, nodeKind kind, std::size_t size){
+         if(ctx.mode == Binary)
+         {
+            static const unsigned char tags[] = { TagContainer, TagTuple, TagObject, TagRange };
+            ctx.out.put(tags[kind]);
+            if(kind == ContainerNode || kind == TupleNode) ctx.out.writeVarint(size);
+         }
+         else if(ctx.mode == JSON)
+         {
+            beginJSONValue(ctx);
+            ctx.out.put(kind == ObjectNode ? '{' : '[');
+            ctx.separate = false;
+         }
+         else
+         {
+            static const char* const kinds[] = { " ( Container with ", " ( Tuple with " };
+            ctx.out << beginDelim(ctx) << ctx.name();
+            if(kind == ObjectNode) ctx.out << " ( Object )";
+            else if(kind == RangeNode) ctx.out << " ( Range )";
+            else ctx.out << kinds[kind] << size << " elements )";
+            ctx.out << endDelim(ctx);
+         }
+         ctx.depth++;};
+
+      /**
+       * @brief Finish variable opened by openNode
+       */
+      auto closeNode = [](context& ctx, nodeKind kind){
+         ctx.depth--;
+         if(ctx.mode == Binary) ctx.out.put(TagEnd);
+         else if(ctx.mode == JSON)
+         {
+            ctx.out.put(kind == ObjectNode ? '}' : ']');
+            ctx.separate = true;
+         }};
+
+      /**
+       * @brief Finish a range opened by openNode, count elements were 
+       * printed and more ones were left (uncounted) if more is set
+       */
+      auto closeRange = [](context& ctx, std::size_t count, bool more){
+         ctx.depth--;
+         if(ctx.mode == Binary)
+         {
+            ctx.out.put(TagEnd);
+            ctx.out.writeVarint(count);
+         }
+         else if(ctx.mode == JSON)
+         {
+            ctx.out.put(']');
+            ctx.separate = true;
+         }
+         else 
+            ctx.out << beginDelim(ctx) << ctx.name() << " ( End of range, " 
+                    << (more ? "more than " : "") << count << " elements )" << endDelim(ctx);};
+
+      /**
+       * @brief Line summarizing count elements that were not printed
+       */
+      auto skipMarker = [](context& ctx, std::size_t count){
+         if(ctx.mode == Binary)
+         {
+            ctx.out.put(TagSkip);
+            ctx.out.writeVarint(count);
+         }
+         else if(ctx.mode == JSON)
+         {
+            beginJSONValue(ctx);
+            ctx.out << "\"... (" << count << " more elements)\"";
+         }
+         else ctx.out << beginDelim(ctx) << "... (" << count << " more elements)" << endDelim(ctx);};
+
+      /**
+       * @brief Line telling that a range has elements that were not printed,
+       * nor counted
+       */
+      auto moreMarker = [](context& ctx){
+         if(ctx.mode == Binary) ctx.out.put(TagMore);
+         else if(ctx.mode == JSON)
+         {
+            beginJSONValue(ctx);
+            ctx.out << "\"... (more elements)\"";
+         }
+         else ctx.out << beginDelim(ctx) << "... (more elements)" << endDelim(ctx);};
+
+      /**
+       * @brief Leave out count elements without any marker (stride sampling)
+       */
+      auto skipGap = [](context& ctx, std::size_t count){
+         if(ctx.mode != Binary) return;
+         ctx.out.put(TagGap);
+         ctx.out.writeVarint(count);};
+
+      /**
+       * @brief Line replacing the members of an object beyond options::maxDepth
+       */
+      auto hiddenMembers = [](context& ctx){
+         if(ctx.mode == Binary) ctx.out.put(TagHidden);
+         else if(ctx.mode == JSON)
+         {
+            ctx.key = "...";
+            beginJSONValue(ctx);
+            ctx.out.writeJSONString("members not shown");
+         }
+         else ctx.out << beginDelim(ctx) << "... (members not shown)" << endDelim(ctx);};
+
+      /**
+       * @brief Line for a variable that can't be printed
+       */
+      auto notPrintable = [](context& ctx){
+         if(ctx.mode == Binary) ctx.out.put(TagNotPrintable);
+         else if(ctx.mode == JSON)
+         {
+            beginJSONValue(ctx);
+            ctx.out.write("null", 4);
+         }
+         else ctx.out << beginDelim(ctx) << ctx.name() <<" can't be printed. \n ";};
+
+      /**
+       * @brief Line for an element at path that was removed since the 
+       * previous diff (see snapshot)
+       */
+      auto removedMarker = [](context& ctx, std::string_view path){
+         if(ctx.mode == Binary) ctx.out.put(TagRemoved);
+         else if(ctx.mode == JSON)
+         {
+            ctx.key = path;
+            beginJSONValue(ctx);
+            ctx.out << "{\"removed\":true}";
+         }
+         else ctx.out << beginDelim(ctx) << path << " ( removed )" << endDelim(ctx);};
+
+      /**
+       * @brief Print header of an object reached through a pointer the 
+       * first time, the object follows one level deeper
+       */
+      auto openPointer = [](context& ctx, std::size_t id){
+         if(ctx.mode == Binary)
+         {
+            ctx.out.put(TagPointer);
+            ctx.out.writeVarint(id);
+         }
+         else if(ctx.mode == JSON)
+         {
+            beginJSONValue(ctx);
+            ctx.out << "{\"id\":" << id;
+            ctx.separate = true;
+            ctx.key = "value";
+         }
+         else ctx.out << beginDelim(ctx) << ctx.name() << " ( Pointer #" << id << " )" << endDelim(ctx);
+         ctx.depth++;};
+
+      /**
+       * @brief Finish object opened by openPointer
+       */
+      auto closePointer = [](context& ctx){
+         ctx.depth--;
+         if(ctx.mode == JSON)
+         {
+            ctx.out.put('}');
+            ctx.separate = true;
+         }};
+
+      /**
+       * @brief Pointer to an object printed before, as #id
+       */
+      auto pointerRef = [](context& ctx, std::size_t id){
+         if(ctx.mode == Binary)
+         {
+            ctx.out.put(TagPointerRef);
+            ctx.out.writeVarint(id);
+         }
+         else if(ctx.mode == JSON)
+         {
+            beginJSONValue(ctx);
+            ctx.out << "{\"ref\":" << id << '}';
+         }
+         else ctx.out << beginDelim(ctx) << ctx.name() << middleDelim(ctx) 
+            << "( see #" << id << " )" << endDelim(ctx);};
+
+      auto nullPointer = [](context& ctx){
+         if(ctx.mode == Binary) ctx.out.put(TagNull);
+         else if(ctx.mode == JSON)
+         {
+            beginJSONValue(ctx);
+            ctx.out.write("null", 4);
+         }
+         else ctx.out << beginDelim(ctx) << ctx.name() << middleDelim(ctx) << "nullptr" << endDelim(ctx);};
+
+      /**
+       * @brief Line ending a (text) reflection that was cut at maxBytes. In 
+       * JSON mode the cut object is not valid JSON, so a separate 
+       * {"truncated":maxBytes} object follows it.
+       */
+      auto truncatedMarker = [](context& ctx, std::size_t maxBytes){
+         if(ctx.mode == JSON) ctx.out << "\n{\"truncated\":" << maxBytes << "}\n";
+         else ctx.out << endDelim(ctx) << "... (output truncated at " 
+            << maxBytes << " bytes)" << endDelim(ctx);};
+
+      /**
+       * @brief Binary tag of a scalar type
+       */
+      template<typename T>
+         constexpr binaryTag binaryTagOf()
+         {
+            typedef scalar_var<T> traits;
+            if(traits::is_bool) return TagBool;
+            if(traits::is_char) return TagChar;
+            if(std::is_same<T, float>::value) return TagFloat;
+            if(std::is_same<T, double>::value) return TagDouble;
+            if(!traits::is_integer) return TagText;
+            const int log2Size = sizeof(T) == 1 ? 0 : sizeof(T) == 2 ? 1 : sizeof(T) == 4 ? 2 : 3;
+            return static_cast<binaryTag>((std::is_signed<T>::value ? TagInt8 : TagUInt8) + log2Size);
+         }
+
+      /**
+       * @brief Write value of a variable in Binary mode
+       */
+      template<typename T>
+         void writeBinaryValue(writer& out, const T& t)
+         {
+            constexpr binaryTag tag = binaryTagOf<T>();
+            if constexpr (tag == TagBool || tag == TagChar)
+            {
+               out.put(tag);
+               out.put(static_cast<char>(t));
+            }
+            else if constexpr (tag != TagText)
+            {
+               out.put(tag);
+               out.writeLittleEndian(t);
+            }
+            else if constexpr (scalar_var<T>::is_cstring || scalar_var<T>::is_string)
+            {
+               const std::string_view str = stringOf(t);
+               out.put(TagString);
+               out.writeVarint(str.size());
+               out.write(str.data(), str.size());
+            }
+            else
+            {
+               scratchBuffer text;
+               {
+                  writer textOut(text.str());
+                  textOut << t;
+               }
+               out.put(TagText);
+               out.writeVarint(text.str().size());
+               out.write(text.str().data(), text.str().size());
+            }
+         }
+
+      /**
+       * @brief Write value of a variable in JSON mode. Numbers and bools as 
+       * they are (non finite floating points as null), everything else as a
+       * string.
+       */
+      template<typename T>
+         void writeJSONValue(writer& out, const T& t)
+         {
+            typedef scalar_var<T> traits;
+            if constexpr (traits::is_bool || traits::is_integer) out.writeScalar(t);
+            else if constexpr (traits::is_float) 
+            {
+               if(std::isfinite(t)) out.writeScalar(t);
+               else out.write("null", 4);
+            }
+            else if constexpr (traits::is_char)
+            {
+               const char c = static_cast<char>(t);
+               out.writeJSONString(std::string_view(&c, 1));
+            }
+            else if constexpr (traits::is_cstring || traits::is_string) 
+               out.writeJSONString(stringOf(t));
+            else
+            {
+               // types printed via << need escaping, format them aside first
+               scratchBuffer text;
+               {
+                  writer textOut(text.str());
+                  textOut << t;
+               }
+               out.writeJSONString(text.str());
+            }
+         }
+
+      /**
+       * @brief Print a variable that has no sub-variables, named name in 
+       * List/CSV mode (ctx.key in JSON mode)
+       */
+      template<typename T>
+         void writeLeaf(context& ctx, const T& t, std::string_view name)
+         {
+            if(ctx.mode == Binary) return writeBinaryValue(ctx.out, t);
+            if(ctx.mode == JSON)
+            {
+               beginJSONValue(ctx);
+               return writeJSONValue(ctx.out, t);
+            }
+            ctx.out << beginDelim(ctx) << name << middleDelim(ctx);
+            if(scalar_var<T>::value && ctx.opts.streamScalars) ctx.out.stream() << t;
+            else ctx.out << t;
+            ctx.out << endDelim(ctx);
+         }
+
+      /**
+       * @brief Print a variable that has no sub-variables
+       */
+      template<typename T>
+         void writeLeaf(context& ctx, const T& t)
+         {
+            writeLeaf(ctx, t, ctx.name());
+         }
+
+      /**
+       * @brief JSON: add members printed by a string returning reflect() API 
+       * to the object being reflected. Its output is a whole JSON object,
+       * unless reflect() forced a text mode (then it is added as "text").
+       */
+      auto jsonMembers = [](context& ctx, std::string_view members){
+         if(members.size() >= 3 && members.front() == '{' && members.substr(members.size() - 2) == "}\n")
+         {
+            members = members.substr(1, members.size() - 3);
+            if(members.empty()) return;
+            if(ctx.separate) ctx.out.put(',');
+            ctx.out.write(members.data(), members.size());
+            ctx.separate = true;
+         }
+         else
+         {
+            ctx.key = "text";
+            beginJSONValue(ctx);
+            ctx.out.writeJSONString(members);
+         }};
+
+      /**
+       * @brief true while asyncQueue captures variables on this thread: call
+       * sites are then referred to by address instead of by their names
+       */
+      inline bool& capturingSites()
+      {
+         thread_local bool capturing = false;
+         return capturing;
+      }
+
+      /**
+       * @brief Send the names of a call site in Binary mode, if not sent yet 
+       * in the current binaryNamesEpoch (or always, see 
+       * options::binaryNamesPerRecord). Captures only send its address.
+       */
+      inline void writeBinaryNames(writer& out, callSiteState& site, const options& opts)
+      {
+         if(capturingSites())
+         {
+            out.put(TagSiteRef);
+            out.writeLittleEndian(static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(&site)));
+            return;
+         }
+         if(!opts.binaryNamesPerRecord && !site.claimBinaryNames()) return;
+         out.put(TagSiteDef);
+         out.writeVarint(site.id());
+         out.writeVarint(site.names.size());
+         for(std::size_t i = 0; i < site.names.size(); i++)
+         {
+            out.writeVarint(site.names[i].size());
+            out.write(site.names[i].data(), site.names[i].size());
+         }
+      }
+
+      /**
+       * @brief Start the variables of a macro call in Binary mode
+       */
+      inline void openBinaryCall(writer& out, callSiteState& site)
+      {
+         out.put(TagCall);
+         out.writeVarint(site.id());
+         out.writeVarint(site.names.size());
+      }
+
+      /**
+       * @brief How a variable is printed, one classification per type (see 
+       * kindOf)
+       */
+      enum kindList {
+         ObjectKind = 0, // has an API named reflect or CPPREFLECT_FIELDS
+         LeafKind,       // has a << operator
+         ContainerKind,  // has size(), begin() and end()
+         TupleKind,      // std::tuple, std::pair, etc..
+         NotPrintableKind,
+         PointerKind,    // raw, unique and shared pointers to objects
+         RangeKind       // has begin() and end() only, e.g. std::forward_list 
+                         // or a lazily produced sequence, iterated once
+      };
+
+      //------------------------------------------------------------------------
+      // APIs a variable type may offer, each one is well formed only if T has it
+      //------------------------------------------------------------------------
+      template<typename T>
+         using reflect_api = decltype(std::declval<const T&>().reflect());
+      template<typename T>
+         using reflect_sink_api = decltype(std::declval<const T&>().reflect(std::declval<context&>()));
+      template<typename T>
+         using fields_api = decltype(cppReflectFields(std::declval<const T*>()));
+      template<typename T>
+         using ltlt_member_api = decltype(std::declval<std::ostream&>().operator<<(std::declval<const T&>()));
+      template<typename T>
+         using ltlt_free_api = decltype(operator<<(std::declval<std::ostream&>(), std::declval<const T&>()));
+      template<typename T>
+         using container_api = decltype(std::declval<const T&>().size(), 
+                                        std::declval<const T&>().begin(), 
+                                        std::declval<const T&>().end());
+      template<typename T>
+         using range_api = decltype(std::declval<const T&>().begin() != 
+                                    std::declval<const T&>().end());
+      template<typename T>
+         using number_data_api = decltype(*std::declval<const T&>().data());
+      template<typename T>
+         using tuple_api = decltype(std::tuple_size<T>::value);
+
+      template<typename T>
+         struct smart_pointer : std::false_type {};
+      template<typename T, typename D>
+         struct smart_pointer<std::unique_ptr<T, D>> : std::true_type {};
+      template<typename T>
+         struct smart_pointer<std::shared_ptr<T>> : std::true_type {};
+
+      /**
+       * @brief true if T points to a single object which can be reflected
+       * (not a C string, void, function or array)
+       */
+      template<typename T>
+         constexpr bool isObjectPointer()
+         {
+            if constexpr (std::is_pointer<T>::value)
+            {
+               typedef typename std::remove_pointer<T>::type elem;
+               return ( !scalar_var<T>::is_cstring && !std::is_void<elem>::value &&
+                        !std::is_function<elem>::value );
+            }
+            else if constexpr (smart_pointer<T>::value)
+            {
+               typedef typename T::element_type elem;
+               return !std::is_void<elem>::value && !std::is_array<elem>::value;
+            }
+            else return false;
+         }
+
+      /**
+       * @brief Address of the object a raw or smart pointer points to
+       */
+      template<typename T>
+         auto pointee(const T& t)
+         {
+            if constexpr (std::is_pointer<T>::value) return t;
+            else return t.get();
+         }
+
+      /**
+       * @brief true_type if Api<T> is well formed
+       */
+      template<typename T, template<typename> class Api, typename = void>
+         struct has_api : std::false_type {};
+      template<typename T, template<typename> class Api>
+         struct has_api<T, Api, std::void_t<Api<T>>> : std::true_type {};
+
+      /**
+       * @brief Classify T, probes are tried in order of priority and only 
+       * until one matches, so e.g. a type with a << operator is never probed 
+       * for container APIs.
+       */
+      template<typename T>
+         constexpr kindList kindOf()
+         {
+            if constexpr (isObjectPointer<T>()) return PointerKind;
+            else if constexpr (std::disjunction<has_api<T, reflect_api>, 
+                                                has_api<T, reflect_sink_api>,
+                                                has_api<T, fields_api>>::value) return ObjectKind;
+            else if constexpr (std::disjunction<has_api<T, ltlt_member_api>, 
+                                                has_api<T, ltlt_free_api>>::value) return LeafKind;
+            else if constexpr (has_api<T, container_api>::value) return ContainerKind;
+            else if constexpr (has_api<T, tuple_api>::value) return TupleKind;
+            else if constexpr (has_api<T, range_api>::value) return RangeKind;
+            else return NotPrintableKind;
+         }
+
+      /**
+       * @brief true if container T has a data() API returning a pointer to a 
+       * number (e.g. std::vector<int>, std::array<float, N>)
+       */
+      template<typename T>
+         constexpr bool isNumberArray()
+         {
+            if constexpr (has_api<T, number_data_api>::value)
+            {
+               typedef typename std::remove_cv<typename std::remove_pointer<
+                  decltype(std::declval<const T&>().data())>::type>::type elem;
+               return ( scalar_var<elem>::is_integer || 
+                        std::is_same<elem, float>::value ||
+                        std::is_same<elem, double>::value );
+            }
+            else return false;
+         }
+
+      /**
+       * @brief true if printing a T may start a nested reflection, hence 
+       * claim the Binary names of a call site (see writeBinaryNames)
+       */
+      template<typename T>
+         constexpr bool usesCallSites();
+
+      template<typename T, std::size_t... I>
+         constexpr bool anyUsesCallSites(std::index_sequence<I...>)
+         {
+            return (false || ... || usesCallSites<std::decay_t<std::tuple_element_t<I, T>>>());
+         }
+
+      template<typename T>
+         constexpr bool usesCallSites()
+         {
+            constexpr kindList kind = kindOf<T>();
+            if constexpr (kind == ObjectKind || kind == PointerKind) return true;
+            else if constexpr (kind == ContainerKind || kind == RangeKind)
+               return usesCallSites<std::decay_t<decltype(*std::declval<const T&>().begin())>>();
+            else if constexpr (kind == TupleKind)
+               return anyUsesCallSites<T>(std::make_index_sequence<std::tuple_size<T>::value>());
+            else return false;
+         }
+
+      //------------------------------------------------------------------------
+      // Declaration
+      //------------------------------------------------------------------------
+      /**
+       * @brief print variable of any type, as classified by kindOf
+       */
+      template<typename T>
+         void _processNameValue(context& ctx, const T& t);
+
+      /**
+       * @brief print element idx of a container or tuple
+       *
+       * @return false if the writer is full, nothing more has to be printed
+       */
+      template<typename T>
+         bool reflectElement(context& ctx, std::size_t idx, const T& t);
+
+      /**
+       * @brief diff variable against the snapshot of ctx (see snapshot)
+       */
+      template<typename T>
+         void diffValue(context& ctx, const T& t);
+
+      /**
+       * @brief print the fields of an object registered with 
+       * CPPREFLECT_FIELDS, as members of the object
+       */
+      template<typename T>
+         void reflectFields(context& ctx, const T& t);
+
+      //------------------------------------------------------------------------
+      // Definition 
+      //------------------------------------------------------------------------
+      /**
+       * @brief true for objects whose members are reflected into the 
+       * output of the parent: 'reflect(CppReflection::context&)' API or 
+       * CPPREFLECT_FIELDS
+       */
+      template<typename T>
+         constexpr bool visitsMembers()
+         {
+            return std::disjunction<has_api<T, reflect_sink_api>, has_api<T, fields_api>>::value;
+         }
+
+      template<typename T>
+         void reflectMembers(context& ctx, const T& t)
+         {
+            if constexpr (has_api<T, reflect_sink_api>::value) t.reflect(ctx);
+            else reflectFields(ctx, t);
+         }
+
+      /**
+       * @brief print pointer, as its address unless pointers are followed
+       */
+      template<typename T>
+         void reflectPointer(context& ctx, const T& t)
+         {
+            if(!ctx.pointers)
+            {
+               if constexpr (std::disjunction<has_api<T, ltlt_member_api>, 
+                                              has_api<T, ltlt_free_api>>::value) writeLeaf(ctx, t);
+               else notPrintable(ctx);
+               return;
+            }
+            const auto* target = pointee(t);
+            if(!target) return nullPointer(ctx);
+            bool added = false;
+            const std::size_t id = ctx.pointers->idOf(target, added);
+            if(!added) return pointerRef(ctx, id);
+            openPointer(ctx, id);
+            if(beyondMaxDepth(ctx)) skipMarker(ctx, 1);
+            else
+            {
+               const std::size_t mark = ctx.path.push("*");
+               _processNameValue(ctx, *target);
+               ctx.path.pop(mark);
+            }
+            closePointer(ctx);
+         }
+
+      /**
+       * @brief print variable that has an API named reflect
+       */
+      template<typename T>
+         void reflectObject(context& ctx, const T& t)
+         {
+            openNode(ctx, ObjectNode, 0);
+            if(beyondMaxDepth(ctx)) hiddenMembers(ctx);
+            else if constexpr (visitsMembers<T>()) reflectMembers(ctx, t);
+            else if(ctx.mode == Binary)
+            {
+               // a Binary record, unless reflect() forced a text mode
+               const std::string members = t.reflect();
+               if(members.empty() || (members[0] != TagSiteDef && members[0] != TagSiteRef &&
+                                      members[0] != TagRecord && members[0] != TagRecordPart))
+                  writeBinaryValue(ctx.out, members);
+               else ctx.out.write(members.data(), members.size());
+            }
+            else if(ctx.mode == JSON) jsonMembers(ctx, t.reflect());
+            else ctx.out << t.reflect();
+            closeNode(ctx, ObjectNode);
+         }
+
+      /**
+       * @brief print elements of a tuple, in order, until the writer is full
+       */
+      template<typename T, std::size_t... I>
+         void reflectTupleElements(context& ctx, const T& t, std::index_sequence<I...>)
+         {
+            (void) ctx; (void) t;
+            (void) (... && reflectElement(ctx, I, std::get<I>(t)));
+         }
+
+      /**
+       * @brief print variable of tuple type 
+       */
+      template<typename T>
+         void reflectTuple(context& ctx, const T& t)
+         {
+            constexpr std::size_t size = std::tuple_size<T>::value;
+            openNode(ctx, TupleNode, size);
+            if(beyondMaxDepth(ctx)) skipMarker(ctx, size);
+            else reflectTupleElements(ctx, t, std::make_index_sequence<size>());
+            closeNode(ctx, TupleNode);
+         }
+
+      /**
+       * @brief print every stride'th container element from it (element i) 
+       * up to element end. Random access iterators jump from one printed 
+       * element to the next.
+       */
+      template<typename It>
+         void reflectElements(context& ctx, It& it, std::size_t& i, 
+                              std::size_t end, std::size_t stride)
+         {
+            if constexpr (std::is_base_of<std::random_access_iterator_tag, 
+                  typename std::iterator_traits<It>::iterator_category>::value)
+            {
+               const std::size_t first = std::min(end, (i + stride - 1) / stride * stride);
+               it += first - i;
+               i = first;
+               while(i < end)
+               {
+                  if(i && stride > 1) skipGap(ctx, stride - 1);
+                  if(!reflectElement(ctx, i, *it)) return;
+                  const std::size_t next = std::min(end, i + stride);
+                  it += next - i;
+                  i = next;
+               }
+            }
+            else
+            {
+               for(; i < end; ++i, ++it)
+               {
+                  if(i % stride) continue;
+                  if(i && stride > 1) skipGap(ctx, stride - 1);
+                  if(!reflectElement(ctx, i, *it)) return;
+               }
+            }
+         }
+
+      /**
+       * @brief true if none of count numbers data[0], data[stride], ... is 
+       * an infinity or NaN
+       */
+      template<typename T>
+         bool allFinite(const T* data, std::size_t count, std::size_t stride)
+         {
+            if constexpr (std::is_floating_point<T>::value)
+               for(std::size_t i = 0; i < count; i++)
+                  if(!std::isfinite(data[i * stride])) return false;
+            (void) data; (void) count; (void) stride;
+            return true;
+         }
+
+      /**
+       * @brief print contiguous container of numbers on one line (a JSON 
+       * array in JSON mode)
+       */
+      template<typename T>
+         void reflectNumberArray(context& ctx, const T& t)
+         {
+            const auto* data = t.data();
+            const std::size_t size = t.size(), maxElements = ctx.opts.maxElements;
+            const bool json = ctx.mode == JSON;
+            const std::string_view sep = json ? "," : ", ";
+            bool first = true;
+            auto numbers = [&](std::size_t from, std::size_t count, std::size_t stride) {
+               if(!count) return;
+               CppReflectCountElements_(count);
+               if(!first) ctx.out << sep;
+               first = false;
+               if(!json || allFinite(data + from, count, stride))
+                  return ctx.out.writeNumbers(data + from, count, stride, sep);
+               for(std::size_t i = 0; i < count; i++)
+               {
+                  if(i) ctx.out << sep;
+                  writeJSONValue(ctx.out, data[from + i * stride]);
+               }
+            };
+            auto marker = [&](std::size_t count) {
+               if(!count) return;
+               if(!first) ctx.out << sep;
+               if(json) ctx.out << '"';
+               ctx.out << "... (" << count << " more elements)";
+               if(json) ctx.out << '"';
+               first = false;
+            };
+            if(json)
+            {
+               beginJSONValue(ctx);
+               ctx.out << '[';
+            }
+            else ctx.out << beginDelim(ctx) << ctx.name() << middleDelim(ctx) << '[';
+            if(size <= maxElements)
+            {
+               numbers(0, size, 1);
+            }
+            else if(ctx.opts.sampling == options::HeadTail)
+            {
+               const std::size_t head = (maxElements + 1) / 2;
+               numbers(0, head, 1);
+               marker(size - maxElements);
+               numbers(size - (maxElements - head), maxElements - head, 1);
+            }
+            else if(ctx.opts.sampling == options::Stride && maxElements)
+            {
+               const std::size_t stride = (size + maxElements - 1) / maxElements;
+               const std::size_t count = (size + stride - 1) / stride;
+               numbers(0, count, stride);
+               marker(size - count);
+            }
+            else
+            {
+               numbers(0, maxElements, 1);
+               marker(size - maxElements);
+            }
+            ctx.out << ']';
+            if(!json) ctx.out << endDelim(ctx);
+         }
+
+      /**
+       * @brief write contiguous container of numbers in Binary mode, as raw
+       * little-endian bytes
+       */
+      template<typename T>
+         void writeBinaryNumberArray(context& ctx, const T& t)
+         {
+            typedef typename std::remove_cv<typename std::remove_pointer<
+               decltype(t.data())>::type>::type elem;
+            ctx.out.put(TagNumberArray);
+            ctx.out.put(binaryTagOf<elem>());
+            ctx.out.writeVarint(t.size());
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            for(const elem& e : t) ctx.out.writeLittleEndian(e);
+#else
+            ctx.out.write(reinterpret_cast<const char*>(t.data()), t.size() * sizeof(elem));
+#endif
+         }
+
+      /**
+       * @brief A container formatted in chunks on the formatPool: chunk k 
+       * holds elements [k * chunkSize, (k + 1) * chunkSize), starting at 
+       * starts[k]
+       */
+      template<typename It>
+         struct parallelJob {
+            context& ctx;
+            std::string name; // of the container, the path of the caller changes
+            std::vector<It> starts;
+            std::size_t chunkSize, size;
+            std::vector<std::string>& buffers;
+#if CPPREFLECT_INSTRUMENT
+            std::atomic<std::uint64_t> elements{0}; // visited by the chunks
+#endif
+         };
+
+      /**
+       * @brief Path of the chunks formatted by this thread, apart from the 
+       * path of the reflection that runs chunks on the calling thread
+       */
+      inline pathBuffer& chunkPath()
+      {
+         thread_local pathBuffer path;
+         return path;
+      }
+
+      /**
+       * @brief Format one chunk of a parallelJob into its buffer, in the 
+       * same context the serial loop would have (mode, depth, options, 
+       * element names)
+       */
+      template<typename It>
+         void formatChunk(void* arg, std::size_t chunk)
+         {
+            parallelJob<It>& job = *static_cast<parallelJob<It>*>(arg);
+            std::string& buf = job.buffers[chunk];
+            buf.clear();
+            const options::scope scope(job.ctx.opts);
+            writer out(buf);
+            pathBuffer& path = chunkPath();
+            path.pop(0);
+            context chunkCtx(out, job.ctx.mode, job.ctx.depth, &path);
+            chunkCtx.separate = chunk > 0 || job.ctx.separate;
+            const std::size_t mark = chunkCtx.path.push(job.name);
+#if CPPREFLECT_INSTRUMENT
+            // counted on the calling thread, whichever thread runs the chunk
+            std::uint64_t& elements = threadSiteCounters::elements();
+            const std::uint64_t before = elements;
+#endif
+            It it = job.starts[chunk];
+            const std::size_t end = std::min(job.size, (chunk + 1) * job.chunkSize);
+            for(std::size_t i = chunk * job.chunkSize; i < end; ++i, ++it) reflectElement(chunkCtx, i, *it);
+            chunkCtx.path.pop(mark);
+#if CPPREFLECT_INSTRUMENT
+            job.elements.fetch_add(elements - before, std::memory_order_relaxed);
+            elements = before;
+#endif
+         }
+
+      /**
+       * @brief Print all elements of container t on the formatPool (see 
+       * options::parallelThreads)
+       *
+       * @return false if t has to be printed serially
+       */
+      template<typename T>
+         bool reflectElementsParallel(context& ctx, const T& t)
+         {
+            typedef std::decay_t<decltype(t.begin())> It;
+            typedef std::decay_t<decltype(*t.begin())> elem;
+            const options& opts = ctx.opts;
+            const std::size_t size = t.size(), threads = opts.parallelThreads;
+            if(threads < 2 || size < opts.parallelMinElements || size < 2 || 
+               opts.maxBytes != options::unlimited || ctx.pointers || ctx.diff)
+               return false;
+            if(ctx.mode == Binary && usesCallSites<elem>() && !opts.binaryNamesPerRecord) return false;
+
+            formatPool& pool = formatPool::global();
+            const formatPool::claimScope claimed(pool);
+            if(!claimed) return false;
+            // a few chunks per thread, so that threads done early take over
+            const std::size_t chunks = std::min(size, 4 * threads);
+            const std::size_t chunkSize = (size + chunks - 1) / chunks;
+            std::vector<std::string>& buffers = pool.buffers();
+            parallelJob<It> job{ctx, std::string(ctx.name()), std::vector<It>(), chunkSize, size, buffers};
+            job.starts.reserve(chunks);
+            if constexpr (std::is_base_of<std::random_access_iterator_tag, 
+                  typename std::iterator_traits<It>::iterator_category>::value)
+            {
+               for(std::size_t i = 0; i < size; i += chunkSize) job.starts.push_back(t.begin() + i);
+            }
+            else
+            {
+               // node based: one walk over the nodes to find where chunks start
+               It it = t.begin();
+               for(std::size_t i = 0; i < size; ++i, ++it) 
+                  if(i % chunkSize == 0) job.starts.push_back(it);
+            }
+            if(buffers.size() < job.starts.size()) buffers.resize(job.starts.size());
+            pool.run(threads, job.starts.size(), formatChunk<It>, &job);
+            CppReflectCountElements_(job.elements.load(std::memory_order_relaxed));
+            for(std::size_t k = 0; k < job.starts.size(); k++) 
+               ctx.out.write(buffers[k].data(), buffers[k].size());
+            ctx.separate = true;
+            return true;
+         }
+
+      /**
+       * @brief print container variable 
+       */
+      template<typename T>
+         void reflectContainer(context& ctx, const T& t)
+         {
+            const std::size_t size = t.size(), maxElements = ctx.opts.maxElements;
+            if constexpr (isNumberArray<T>())
+            {
+               // same output as the element by element path below
+               const bool shown = static_cast<std::size_t>(ctx.depth + 1) <= ctx.opts.maxDepth;
+               if(ctx.mode == Binary && size <= maxElements && shown)
+               {
+                  CppReflectCountElements_(size);
+                  return writeBinaryNumberArray(ctx, t);
+               }
+               if(ctx.mode == JSON && shown) return reflectNumberArray(ctx, t);
+               // one line form, only if asked for
+               if((ctx.mode == List || ctx.mode == CSV) && ctx.opts.compactArrays && shown) 
+                  return reflectNumberArray(ctx, t);
+            }
+            openNode(ctx, ContainerNode, size);
+            std::size_t i = 0;
+            auto it = t.begin();
+            if(beyondMaxDepth(ctx) || (maxElements == 0 && size))
+            {
+               skipMarker(ctx, size);
+            }
+            else if(size <= maxElements)
+            {
+               if(!reflectElementsParallel(ctx, t)) reflectElements(ctx, it, i, size, 1);
+            }
+            else if(ctx.opts.sampling == options::HeadTail)
+            {
+               const std::size_t head = (maxElements + 1) / 2;
+               const std::size_t skip = size - maxElements;
+               reflectElements(ctx, it, i, head, 1);
+               skipMarker(ctx, skip);
+               std::advance(it, skip); i += skip;
+               reflectElements(ctx, it, i, size, 1);
+            }
+            else if(ctx.opts.sampling == options::Stride)
+            {
+               const std::size_t stride = (size + maxElements - 1) / maxElements;
+               reflectElements(ctx, it, i, size, stride);
+               skipMarker(ctx, size - (size + stride - 1) / stride);
+            }
+            else
+            {
+               reflectElements(ctx, it, i, maxElements, 1);
+               skipMarker(ctx, size - maxElements);
+            }
+            closeNode(ctx, ContainerNode);
+         }
+
+      /**
+       * @brief print container without size(), in one pass: its count is 
+       * known, and printed, at the end only. options::sampling is always
+       * Head. The range is not walked beyond maxElements (it may never end), 
+       * the elements left are only marked as more elements.
+       */
+      template<typename T>
+         void reflectRange(context& ctx, const T& t)
+         {
+            const std::size_t maxElements = beyondMaxDepth(ctx) ? 0 : ctx.opts.maxElements;
+            openNode(ctx, RangeNode, 0);
+            std::size_t count = 0;
+            auto it = t.begin();
+            const auto end = t.end();
+            for(; it != end && count < maxElements; ++it, ++count)
+               if(!reflectElement(ctx, count, *it)) break;
+            if(ctx.out.full()) return closeRange(ctx, count, false);
+            const bool more = it != end;
+            if(more) moreMarker(ctx);
+            closeRange(ctx, count, more);
+         }
+
+      template<typename T>
+         void _processNameValue(context& ctx, const T& t)
+         {
+            CppReflectCountElements_(1);
+            constexpr kindList kind = kindOf<T>();
+            if(ctx.diff) diffValue(ctx, t);
+            else if constexpr (kind == ObjectKind) reflectObject(ctx, t);
+            else if constexpr (kind == LeafKind) writeLeaf(ctx, t);
+            else if constexpr (kind == ContainerKind) reflectContainer(ctx, t);
+            else if constexpr (kind == TupleKind) reflectTuple(ctx, t);
+            else if constexpr (kind == PointerKind) reflectPointer(ctx, t);
+            else if constexpr (kind == RangeKind) reflectRange(ctx, t);
+            else
+            {
+               (void) t;
+               notPrintable(ctx);
+            }
+         }
+
+      template<typename T>
+         bool reflectElement(context& ctx, std::size_t idx, const T& t)
+         {
+            if(ctx.out.full()) return false;
+            const std::size_t mark = ctx.path.pushIndex(idx);
+            _processNameValue(ctx, t);
+            ctx.path.pop(mark);
+            return true;
+         }
+
+      /**
+       * @brief print one variable passed to a macro
+       *
+       * @return false if the writer is full, nothing more has to be printed
+       */
+      template<typename T>
+         bool reflectVariable(context& ctx, std::string_view name, const T& t)
+         {
+            if(ctx.out.full()) return false;
+            const std::size_t mark = ctx.path.push(name);
+            ctx.key = name;
+            _processNameValue(ctx, t);
+            ctx.path.pop(mark);
+            return true;
+         }
+
+      /**
+       * @brief print all variables passed to a macro, in order, until the 
+       * writer is full
+       */
+      template<typename... T>
+         void _reflect(context& ctx, const nameList& names, const T&... t)
+         {
+            std::size_t idx = 0;
+            (void) (... && reflectVariable(ctx, names[idx++], t));
+         }
+
+      /**
+       * @brief Hash of bytes, for diffs (see snapshot)
+       */
+      inline std::uint64_t hashBytes(const char* data, std::size_t size)
+      {
+         std::uint64_t hash = 0x9e3779b97f4a7c15ull ^ size, word = 0;
+         for(; size >= sizeof(word); data += sizeof(word), size -= sizeof(word))
+         {
+            std::memcpy(&word, data, sizeof(word));
+            hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+            hash ^= hash >> 32;
+         }
+         word = 0;
+         std::memcpy(&word, data, size);
+         hash = (hash ^ word) * 0xc4ceb9fe1a85ec53ull;
+         return hash ^ (hash >> 29);
+      }
+
+      /**
+       * @brief Add hash value to the hash of an element with sub-elements
+       */
+      inline std::uint64_t mixHash(std::uint64_t hash, std::uint64_t value)
+      {
+         hash = (hash ^ value) * 0xff51afd7ed558ccdull;
+         return hash ^ (hash >> 32);
+      }
+
+      /**
+       * @brief true for types hashed from their value as they are (numbers,
+       * strings, ...), these have no record in snapshot::records
+       */
+      template<typename T>
+         constexpr bool hashedDirectly()
+         {
+            typedef scalar_var<T> traits;
+            return ( traits::is_bool || traits::is_char || traits::is_integer ||
+                     std::is_same<T, float>::value || std::is_same<T, double>::value ||
+                     traits::is_cstring || traits::is_string || 
+                     kindOf<T>() == NotPrintableKind || kindOf<T>() == PointerKind );
+         }
+
+      template<typename T>
+         std::uint64_t directHash(const T& t)
+         {
+            typedef scalar_var<T> traits;
+            if constexpr (traits::is_cstring || traits::is_string)
+            {
+               const std::string_view str = stringOf(t);
+               return hashBytes(str.data(), str.size());
+            }
+            else if constexpr (kindOf<T>() == NotPrintableKind) return (void) t, 0;
+            else if constexpr (kindOf<T>() == PointerKind)
+            {
+               const void* address = pointee(t);
+               return hashBytes(reinterpret_cast<const char*>(&address), sizeof(address));
+            }
+            else return hashBytes(reinterpret_cast<const char*>(&t), sizeof(T));
+         }
+
+      /**
+       * @brief Members of an object with a string returning reflect() API, 
+       * as text in Binary mode (a Binary record can't be told apart from 
+       * other strings once in a diff)
+       */
+      template<typename T>
+         std::string diffText(context& ctx, const T& t)
+         {
+            if(ctx.mode != Binary) return t.reflect();
+            ctx.mode = List;
+            std::string ret = t.reflect();
+            ctx.mode = Binary;
+            return ret;
+         }
+
+      /**
+       * @brief First pass of a diff: hash variable t and add records of it
+       * and of its sub-elements to the snapshot of ctx
+       */
+      template<typename T>
+         void hashValue(context& ctx, const T& t)
+         {
+            snapshot& snap = *ctx.diff;
+            std::uint64_t hash = 0;
+            if constexpr (hashedDirectly<T>()) hash = directHash(t);
+            else
+            {
+               constexpr kindList kind = kindOf<T>();
+               const std::size_t at = snap.records.size();
+               snap.records.push_back(snapshot::record());
+               if constexpr (kind == LeafKind)
+               {
+                  scratchBuffer text;
+                  {
+                     writer textOut(text.str());
+                     textOut << t;
+                  }
+                  hash = hashBytes(text.str().data(), text.str().size());
+               }
+               else if constexpr (kind == ObjectKind && !visitsMembers<T>())
+               {
+                  const std::string text = diffText(ctx, t);
+                  hash = hashBytes(text.data(), text.size());
+               }
+               else
+               {
+                  snap.open.push_back(mixHash(kind, 0));
+                  if constexpr (kind == ObjectKind) reflectMembers(ctx, t);
+                  else if constexpr (kind == TupleKind)
+                     std::apply([&ctx](const auto&... e) { (..., _processNameValue(ctx, e)); }, t);
+                  else if constexpr (kind == ContainerKind && isNumberArray<T>())
+                     snap.open.back() = mixHash(hashBytes(reinterpret_cast<const char*>(t.data()), 
+                                                          t.size() * sizeof(*t.data())), t.size());
+                  else
+                  {
+                     std::size_t size = 0;
+                     for(const auto& e : t) { _processNameValue(ctx, e); size++; }
+                     snap.open.back() = mixHash(snap.open.back(), size);
+                  }
+                  hash = snap.open.back();
+                  snap.open.pop_back();
+               }
+               snap.records[at].hash = hash;
+               snap.records[at].below = snap.records.size() - at - 1;
+            }
+            if(!snap.open.empty()) snap.open.back() = mixHash(snap.open.back(), hash);
+         }
+
+      /**
+       * @brief Print a changed element of a diff, named by its path
+       */
+      template<typename T>
+         void writeChange(context& ctx, std::string_view path, const T& t)
+         {
+            if(ctx.mode == Binary) ctx.diff->addBinaryName(path);
+            ctx.key = path;
+            writeLeaf(ctx, t, path);
+         }
+
+      /**
+       * @brief Print that the element being reflected was removed since the
+       * previous diff and forget it
+       */
+      inline void removedElement(context& ctx)
+      {
+         const std::string_view path = ctx.path.view(ctx.diff->pathBase);
+         if(ctx.mode == Binary) ctx.diff->addBinaryName(path);
+         removedMarker(ctx, path);
+         ctx.diff->forget(path);
+      }
+
+      /**
+       * @brief Second pass of a diff: compare t with the snapshot of ctx,
+       * print what changed and update the snapshot
+       */
+      template<typename T>
+         void compareValue(context& ctx, const T& t)
+         {
+            constexpr kindList kind = kindOf<T>();
+            if constexpr (kind == NotPrintableKind) { (void) ctx; (void) t; }
+            else
+            {
+               snapshot& snap = *ctx.diff;
+               std::uint64_t hash = 0;
+               std::size_t below = 0;
+               if constexpr (hashedDirectly<T>()) hash = directHash(t);
+               else
+               {
+                  hash = snap.records[snap.cursor].hash;
+                  below = snap.records[snap.cursor++].below;
+               }
+               bool added = false;
+               snapshot::element& element = snap.track(ctx.path.view(snap.pathBase), added);
+               if(!added && element.hash == hash)
+               {
+                  // unchanged, down to the last sub-element
+                  snap.cursor += below;
+                  return;
+               }
+               if constexpr (kind == LeafKind) writeChange(ctx, ctx.path.view(snap.pathBase), t);
+               else if constexpr (kind == PointerKind) 
+                  writeChange(ctx, ctx.path.view(snap.pathBase), static_cast<const void*>(pointee(t)));
+               else if constexpr (kind == ObjectKind && visitsMembers<T>())
+               {
+                  const std::size_t mark = ctx.path.push(".");
+                  reflectMembers(ctx, t);
+                  ctx.path.pop(mark);
+               }
+               else if constexpr (kind == ObjectKind) 
+                  writeChange(ctx, ctx.path.view(snap.pathBase), diffText(ctx, t));
+               else if constexpr (kind == TupleKind)
+                  reflectTupleElements(ctx, t, std::make_index_sequence<std::tuple_size<T>::value>());
+               else
+               {
+                  // elements with the hash they had are skipped without
+                  // looking them up
+                  // (ranges are walked again by both passes of a diff, so 
+                  // they have to be multi-pass)
+                  std::vector<std::uint64_t>& children = element.children;
+                  std::size_t size = 0;
+                  if constexpr (kind == RangeKind) 
+                     for(auto it = t.begin(); it != t.end(); ++it) size++;
+                  else size = t.size();
+                  const std::size_t known = children.size();
+                  std::size_t i = 0;
+                  for(auto it = t.begin(); it != t.end() && !ctx.out.full(); ++it, ++i)
+                  {
+                     typedef std::decay_t<decltype(*it)> E;
+                     std::uint64_t childHash = 0;
+                     std::size_t skip = 0;
+                     if constexpr (hashedDirectly<E>()) childHash = directHash(*it);
+                     else
+                     {
+                        childHash = snap.records[snap.cursor].hash;
+                        skip = 1 + snap.records[snap.cursor].below;
+                     }
+                     if(i < known && children[i] == childHash)
+                     {
+                        snap.cursor += skip;
+                        continue;
+                     }
+                     reflectElement(ctx, i, *it);
+                     if(ctx.out.full()) break;
+                     if(i < known) children[i] = childHash;
+                     else children.push_back(childHash);
+                  }
+                  for(std::size_t removed = size; removed < known && !ctx.out.full(); removed++)
+                  {
+                     const std::size_t mark = ctx.path.pushIndex(removed);
+                     removedElement(ctx);
+                     ctx.path.pop(mark);
+                  }
+                  if(!ctx.out.full()) children.resize(size);
+               }
+               // compared again next time if the output was cut
+               if(!ctx.out.full()) element.hash = hash;
+            }
+         }
+
+      template<typename T>
+         void diffValue(context& ctx, const T& t)
+         {
+            if(ctx.diff->hashing) hashValue(ctx, t);
+            else compareValue(ctx, t);
+         }
+
+      /**
+       * @brief Variables of one macro call, type erased so that the code 
+       * around reflecting them (modes, framing, limits) is compiled once
+       * rather than per call site and list of types.
+       */
+      struct variableList {
+         void (*reflect)(context& ctx, const nameList& names, const void* vars);
+         const void* vars;
+      };
+
+      /**
+       * @brief variableList::reflect of a tuple of references to variables
+       */
+      template<typename... T>
+         void reflectVariables(context& ctx, const nameList& names, const void* vars)
+         {
+            std::apply([&](const T&... t) { _reflect(ctx, names, t...); },
+                       *static_cast<const std::tuple<const T&...>*>(vars));
+         }
+
+      /**
+       * @brief see reflectTo(context&, ...)
+       */
+      inline std::size_t reflectNested(context& ctx, const modeList modeArg, 
+                                       callSiteState& site, const variableList& vars)
+      {
+         const std::size_t start = ctx.out.size();
+         // nested reflections can't switch into/out of Binary or JSON mode, 
+         // it would corrupt the output
+         auto structured = [](modeList mode){ return mode == Binary || mode == JSON; };
+         context nested(ctx.out, structured(ctx.mode) || structured(modeArg) ? 
+                        ctx.mode : modeArg, ctx.depth);
+         nested.separate = ctx.separate;
+         nested.diff = ctx.diff;
+         if(nested.mode == Binary && !nested.diff)
+         {
+            writeBinaryNames(ctx.out, site, ctx.opts);
+            openBinaryCall(ctx.out, site);
+         }
+         vars.reflect(nested, site.names, vars.vars);
+         ctx.separate = nested.separate;
+         return ctx.out.size() - start;
+      }
+
+      /**
+       * @brief variableList::reflect of the fields of an object registered
+       * with CPPREFLECT_FIELDS
+       */
+      template<typename T>
+         void reflectFieldValues(context& ctx, const nameList& names, const void* object)
+         {
+            const T& t = *static_cast<const T*>(object);
+            std::apply([&](auto... member) { _reflect(ctx, names, t.*member...); }, 
+                       cppReflectFields(&t).members);
+         }
+
+      template<typename T>
+         void reflectFields(context& ctx, const T& t)
+         {
+            reflectNested(ctx, ctx.mode, cppReflectFields(&t).site, {reflectFieldValues<T>, &t});
+         }
+
+      /**
+       * @brief see reflectTo(writer&, ...)
+       */
+      inline std::size_t reflectRecord(writer& oBuffer, const modeList modeArg, 
+                                       callSiteState& site, const variableList& vars)
+      {
+#if CPPREFLECT_INSTRUMENT
+         siteTimer timer(site, oBuffer);
+#endif
+         const std::size_t start = oBuffer.size();
+         if(modeArg == Binary)
+         {
+            // Binary records are length prefixed, so encode into body first,
+            // what goes beyond recordChunkBytes is written ahead in parts
+            scratchBuffer bodyBuffer;
+            std::string& body = bodyBuffer.str();
+            std::pair<writer*, std::string*> parts(&oBuffer, &body);
+            std::size_t maxBytes = 0;
+            bool truncated = false;
+            {
+               writer bodyOut(callbackSink{&parts, 
+                  [](void* parts_, const char* data, std::size_t len) {
+                     auto [out, body] = *static_cast<std::pair<writer*, std::string*>*>(parts_);
+                     body->append(data, len);
+                     if(body->size() < recordChunkBytes) return;
+                     out->put(TagRecordPart);
+                     out->writeLittleEndian(static_cast<std::uint32_t>(body->size()));
+                     out->write(body->data(), body->size());
+                     body->clear(); }});
+               context ctx(bodyOut, Binary, context::nextDepth());
+               writeBinaryNames(oBuffer, site, ctx.opts);
+               maxBytes = ctx.opts.maxBytes;
+               if(maxBytes != options::unlimited) bodyOut.limit(maxBytes);
+               openBinaryCall(bodyOut, site);
+               vars.reflect(ctx, site.names, vars.vars);
+               truncated = maxBytes != options::unlimited && bodyOut.full();
+            }
+            oBuffer.put(TagRecord);
+            oBuffer.writeLittleEndian(static_cast<std::uint32_t>(body.size()));
+            oBuffer.write(body.data(), body.size());
+            if(truncated)
+            {
+               CppReflectCountTruncation_();
+               oBuffer.put(TagTruncated);
+               oBuffer.writeVarint(maxBytes);
+            }
+            return oBuffer.size() - start;
+         }
+         context ctx(oBuffer, modeArg, context::nextDepth());
+         const std::size_t maxBytes = ctx.opts.maxBytes;
+         const bool limited = maxBytes < writer::noLimit - start;
+         if(limited) oBuffer.limit(start + maxBytes);
+         if(modeArg == JSON) oBuffer.put('{');
+         vars.reflect(ctx, site.names, vars.vars);
+         if(modeArg == JSON) oBuffer.write("}\n", 2);
+         if(limited)
+         {
+            const bool truncated = oBuffer.full();
+            oBuffer.limit(writer::noLimit);
+            if(truncated)
+            {
+               CppReflectCountTruncation_();
+               truncatedMarker(ctx, maxBytes);
+            }
+         }
+         return oBuffer.size() - start;
+      }
+
+      /**
+       * @brief see reflectDiffTo(snapshot&, ...)
+       */
+      inline std::size_t reflectDiffRecord(writer& oBuffer, snapshot& snap,
+                                           callSiteState& site, const variableList& vars)
+      {
+#if CPPREFLECT_INSTRUMENT
+         siteTimer timer(site, oBuffer);
+#endif
+         const std::size_t start = oBuffer.size();
+         const modeList mode = snap.mode();
+         // Binary: the changes are one call of call site 0, named by their
+         // paths, the names are only known at the end
+         scratchBuffer namesBuffer, bodyBuffer;
+         std::size_t maxBytes = 0;
+         bool truncated = false;
+         {
+            writer namesOut(namesBuffer.str()), bodyOut(bodyBuffer.str());
+            writer& out = mode == Binary ? bodyOut : oBuffer;
+            context ctx(out, mode, context::nextDepth());
+            ctx.diff = &snap;
+            snap.records.clear();
+            snap.hashing = true;
+            vars.reflect(ctx, site.names, vars.vars);
+            snap.hashing = false;
+            snap.cursor = 0;
+            snap.pathBase = ctx.path.size();
+            snap.binaryNames = &namesOut;
+            snap.changes = 0;
+            maxBytes = ctx.opts.maxBytes;
+            const std::size_t from = out.size();
+            const bool limited = maxBytes < writer::noLimit - from;
+            if(limited) out.limit(from + maxBytes);
+            if(mode == JSON) out.put('{');
+            vars.reflect(ctx, site.names, vars.vars);
+            if(!out.full())
+               snap.updateRoots(site.names, [&ctx](std::string_view root) {
+                  const std::size_t mark = ctx.path.push(root);
+                  removedElement(ctx);
+                  ctx.path.pop(mark); });
+            snap.sweep();
+            if(mode == JSON) out.write("}\n", 2);
+            truncated = limited && out.full();
+            if(truncated) CppReflectCountTruncation_();
+            if(limited) out.limit(writer::noLimit);
+            if(truncated && mode != Binary) truncatedMarker(ctx, maxBytes);
+            snap.binaryNames = nullptr;
+         }
+         if(mode == Binary)
+         {
+            const std::string& names = namesBuffer.str();
+            const std::string& body = bodyBuffer.str();
+            oBuffer.put(TagSiteDef);
+            oBuffer.writeVarint(0);
+            oBuffer.writeVarint(snap.changes);
+            oBuffer.write(names.data(), names.size());
+            oBuffer.put(TagRecord);
+            oBuffer.writeLittleEndian(static_cast<std::uint32_t>(
+                  1 + writer::varintSize(0) + writer::varintSize(snap.changes) + body.size()));
+            oBuffer.put(TagCall);
+            oBuffer.writeVarint(0);
+            oBuffer.writeVarint(snap.changes);
+            oBuffer.write(body.data(), body.size());
+            if(truncated)
+            {
+               oBuffer.put(TagTruncated);
+               oBuffer.writeVarint(maxBytes);
+            }
+         }
+         return oBuffer.size() - start;
+      }
+   } // End of unnamed namespace
+
+   /**
+    * @brief continue reflection of context ctx with given list of variables,
+    * as members of the object being reflected. Used by 
+    * 'reflect(CppReflection::context&)' APIs.
+    *
+    * @param ctx - context of the parent reflection
+    * @param modeArg - mode set from macro
+    * @param site - call site of the macro (names of all variables passed to it)
+    * @param t - first variable passed to macro
+    * @param tRest - all rest of the variables passed to macro
+    *
+    * @return number of bytes written
+    */
+   template<std::size_t N, typename T, typename... TRest>
+      std::size_t reflectTo(context& ctx, const modeList modeArg, 
+                            callSite<N>& site,
+                            const T& t, const TRest&... tRest)
+      {
+         static_assert(N == 1 + sizeof...(TRest), 
+                       "Number of names doesn't match number of variables");
+         const std::tuple<const T&, const TRest&...> vars(t, tRest...);
+         return reflectNested(ctx, modeArg, site, {reflectVariables<T, TRest...>, &vars});
+      }
+
+   /**
+    * @brief reflect given list of variables into the given writer.
+    *
+    * @param oBuffer - writer to write the output in
+    * @param modeArg - mode set from macro
+    * @param site - call site of the macro (names of all variables passed to it)
+    * @param t - first variable passed to macro
+    * @param tRest - all rest of the variables passed to macro
+    *
+    * @return number of bytes written
+    */
+   template<std::size_t N, typename T, typename... TRest>
+      std::size_t reflectTo(writer& oBuffer, const modeList modeArg, 
+                            callSite<N>& site,
+                            const T& t, const TRest&... tRest)
+      {
+         static_assert(N == 1 + sizeof...(TRest), 
+                       "Number of names doesn't match number of variables");
+         const std::tuple<const T&, const TRest&...> vars(t, tRest...);
+         return reflectRecord(oBuffer, modeArg, site, {reflectVariables<T, TRest...>, &vars});
+      }
+
+   namespace {
+      /**
+       * @brief Call reflectIt, with options::binaryNamesPerRecord set if it
+       * writes a Binary record that is decoded on its own (returned string,
+       * ring file record) rather than as part of a stream
+       */
+      template<typename F>
+         void reflectStandalone(const modeList modeArg, F&& reflectIt)
+         {
+            if(modeArg != Binary || context::current()) return reflectIt();
+            options opts = options::current();
+            opts.binaryNamesPerRecord = true;
+            options::scope scope(opts);
+            reflectIt();
+         }
+   }
+
+   /**
+    * @brief Sink keeping the latest reflection output in a memory-mapped
+    * ring file, one record per reflection call, so that what was reflected
+    * right before a crash or SIGKILL can still be read from the file (the
+    * pages belong to the kernel's page cache, not to the process).
+    *
+    * Records are copied into the mapping with memcpy, no system call is made
+    * per record. Every record is 8 byte aligned and framed as
+    *   u32 RecordMagic, u32 length, u64 position   - header
+    *   length bytes of output, zero padded to 8
+    *   u64 size, u64 position ^ CommitKey          - footer
+    * where position is the record's offset in the endless stream of bytes
+    * written to the ring (the ring offset is position % capacity) and the
+    * last word, stored last with release order, is the commit marker. 
+    * Records don't wrap around the end of the ring, the space left there is
+    * skipped. Writers reserve their space with a CAS on the shared head, so
+    * many threads (of one process) may write to the same ring.
+    *
+    * Readers walk back from the head over footers: a record is complete if
+    * its footer and header agree on its size and position, everything else
+    * (a record cut by a crash, data of earlier laps) is stepped over 8 bytes
+    * at a time. Not available on Windows, where open fails.
+    */
+   class ringFile {
+      public:
+         ringFile() = default;
+
+         /**
+          * @brief Open (see open) path for writing
+          */
+         ringFile(const std::string& path, std::size_t capacityBytes) 
+         { 
+            open(path, capacityBytes); 
+         }
+
+         ~ringFile() { close(); }
+
+         ringFile(const ringFile&) = delete;
+         ringFile& operator=(const ringFile&) = delete;
+
+         /**
+          * @brief Map ring file path for writing. An existing ring file is
+          * reused as it is (records of the earlier run are kept, new ones
+          * follow them), otherwise the file is created with room for
+          * capacityBytes (rounded up to 8) of records and their framing.
+          *
+          * @return false if the file can't be created/mapped or isn't a ring
+          */
+         bool open(const std::string& path, std::size_t capacityBytes)
+         {
+            return map(path, capacityBytes, false);
+         }
+
+         /**
+          * @brief Map an existing ring file for reading only
+          */
+         bool openReadOnly(const std::string& path)
+         {
+            return map(path, 0, true);
+         }
+
+         void close()
+         {
+#if !defined(_WIN32)
+            if(base_) ::munmap(base_, headerSize + capacity_);
+#endif
+            base_ = nullptr;
+            capacity_ = 0;
+         }
+
+         bool isOpen() const { return base_ != nullptr; }
+
+         /**
+          * @brief Bytes available for records (framing included)
+          */
+         std::size_t capacity() const { return capacity_; }
+
+         /**
+          * @brief Records not written as they don't fit in the ring, or
+          * were written to a ring that isn't open/is read only
+          */
+         std::size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+         /**
+          * @brief Append record, overwriting the oldest records as needed
+          *
+          * @return false if the record was dropped
+          */
+         bool append(std::string_view record)
+         {
+            const std::uint64_t size = frameSize(record.size());
+            if(!base_ || readOnly_ || size > capacity_)
+            {
+               dropped_.fetch_add(1, std::memory_order_relaxed);
+               return false;
+            }
+            std::atomic<std::uint64_t>& head = word(headOffset);
+            std::uint64_t pos = head.load(std::memory_order_relaxed), start;
+            do
+            {
+               const std::uint64_t offset = pos % capacity_;
+               start = offset + size > capacity_ ? pos + (capacity_ - offset) : pos;
+            } while(!head.compare_exchange_weak(pos, start + size, std::memory_order_relaxed));
+
+            char* p = data() + start % capacity_;
+            const std::uint32_t header[2] = { RecordMagic, static_cast<std::uint32_t>(record.size()) };
+            std::memcpy(p, header, sizeof(header));
+            std::memcpy(p + 8, &start, 8);
+            std::memcpy(p + 16, record.data(), record.size());
+            const std::size_t padded = (record.size() + 7) & ~std::size_t(7);
+            std::memset(p + 16 + record.size(), 0, padded - record.size());
+            std::memcpy(p + 16 + padded, &size, 8);
+            word(dataOffset + start % capacity_ + size - 8).store(start ^ CommitKey, 
+                                                                 std::memory_order_release);
+            return true;
+         }
+
+         /**
+          * @brief Copy the last (up to) count complete records, oldest first
+          */
+         std::vector<std::string> lastRecords(std::size_t count) const
+         {
+            std::vector<std::string> ret;
+            if(!base_) return ret;
+            const std::uint64_t head = word(headOffset).load(std::memory_order_acquire);
+            const std::uint64_t low = head > capacity_ ? head - capacity_ : 0;
+            for(std::uint64_t end = head & ~std::uint64_t(7); 
+                ret.size() < count && end >= low + minFrame; )
+            {
+               const std::uint64_t size = load(end - 16);
+               const std::uint64_t start = end - size;
+               std::uint32_t header[2];
+               if(size < minFrame || size > end - low || size % 8 ||
+                  start % capacity_ + size > capacity_ ||
+                  load(end - 8) != (start ^ CommitKey) || load(start + 8) != start)
+               {
+                  end -= 8;
+                  continue;
+               }
+               std::memcpy(header, data() + start % capacity_, sizeof(header));
+               if(header[0] != RecordMagic || frameSize(header[1]) != size)
+               {
+                  end -= 8;
+                  continue;
+               }
+               ret.emplace_back(data() + start % capacity_ + 16, header[1]);
+               // a writer of this process may have overwritten it meanwhile
+               const std::uint64_t now = word(headOffset).load(std::memory_order_acquire);
+               if(now > capacity_ && start < now - capacity_)
+               {
+                  ret.pop_back();
+                  break;
+               }
+               end = start;
+            }
+            std::reverse(ret.begin(), ret.end());
+            return ret;
+         }
+
+      private:
+         static constexpr char fileMagic[8] = { 'C', 'p', 'p', 'R', 'R', 'i', 'n', 'g' };
+         static constexpr std::uint32_t RecordMagic = 0x43455252; // "RREC"
+         static constexpr std::uint64_t CommitKey = 0x54494d4d4f434552; // "RECOMMIT"
+         // file header: magic, capacity, head (on a cache line of its own)
+         static constexpr std::size_t capacityOffset = 8;
+         static constexpr std::size_t headOffset = 64;
+         static constexpr std::size_t headerSize = 128;
+         static constexpr std::size_t dataOffset = headerSize;
+         static constexpr std::uint64_t minFrame = 32;
+         static_assert(std::atomic<std::uint64_t>::is_always_lock_free, 
+                       "ringFile needs lock free 64 bit atomics");
+
+         static std::uint64_t frameSize(std::size_t length)
+         {
+            return minFrame + ((length + 7) & ~std::size_t(7));
+         }
+
+         char* data() const { return base_ + dataOffset; }
+
+         std::atomic<std::uint64_t>& word(std::size_t offset) const
+         {
+            return *reinterpret_cast<std::atomic<std::uint64_t>*>(base_ + offset);
+         }
+
+         /**
+          * @brief 8 byte word at position pos of the stream (aligned, so 
+          * never split by the end of the ring)
+          */
+         std::uint64_t load(std::uint64_t pos) const
+         {
+            return word(dataOffset + pos % capacity_).load(std::memory_order_acquire);
+         }
+
+         bool map(const std::string& path, std::size_t capacityBytes, bool readOnly)
+         {
+            close();
+#if defined(_WIN32)
+            (void)path; (void)capacityBytes; (void)readOnly;
+            return false;
+#else
+            const int fd = ::open(path.c_str(), readOnly ? O_RDONLY : O_RDWR | O_CREAT, 0644);
+            if(fd < 0) return false;
+            struct stat st;
+            std::uint64_t capacity = 0;
+            bool ok = ::fstat(fd, &st) == 0;
+            if(ok && static_cast<std::size_t>(st.st_size) >= headerSize)
+            {
+               // an existing ring keeps its capacity
+               char header[16];
+               ok = ::pread(fd, header, sizeof(header), 0) == sizeof(header) &&
+                    std::memcmp(header, fileMagic, sizeof(fileMagic)) == 0;
+               if(ok) std::memcpy(&capacity, header + capacityOffset, 8);
+               ok = ok && capacity >= minFrame && capacity % 8 == 0 &&
+                    static_cast<std::uint64_t>(st.st_size) >= headerSize + capacity;
+            }
+            else if(ok && st.st_size == 0 && !readOnly && capacityBytes)
+            {
+               capacity = std::max<std::uint64_t>(minFrame, (capacityBytes + 7) & ~std::size_t(7));
+               char header[headerSize] = {};
+               std::memcpy(header, fileMagic, sizeof(fileMagic));
+               std::memcpy(header + capacityOffset, &capacity, 8);
+               ok = ::ftruncate(fd, headerSize + capacity) == 0 &&
+                    ::pwrite(fd, header, headerSize, 0) == static_cast<ssize_t>(headerSize);
+            }
+            else ok = false;
+            void* base = MAP_FAILED;
+            if(ok) base = ::mmap(nullptr, headerSize + capacity, 
+                                 readOnly ? PROT_READ : PROT_READ | PROT_WRITE, 
+                                 MAP_SHARED, fd, 0);
+            ::close(fd);
+            if(base == MAP_FAILED) return false;
+            base_ = static_cast<char*>(base);
+            capacity_ = capacity;
+            readOnly_ = readOnly;
+            return true;
+#endif
+         }
+
+         char* base_ = nullptr;
+         std::uint64_t capacity_ = 0;
+         bool readOnly_ = false;
+         std::atomic<std::size_t> dropped_{0};
+   };
+
+   /**
+    * @brief reflect given list of variables into ring file ring, as one
+    * record
+    *
+    * @return number of bytes written, 0 if the record was dropped
+    */
+   template<std::size_t N, typename T, typename... TRest>
+      std::size_t reflectTo(ringFile& ring, const modeList modeArg, 
+                            callSite<N>& site,
+                            const T& t, const TRest&... tRest)
+      {
+         scratchBuffer record;
+         reflectStandalone(modeArg, [&]() { reflectTo(record.str(), modeArg, site, t, tRest...); });
+         return ring.append(record.str()) ? record.str().size() : 0;
+      }
+
+   /**
+    * @brief reflect given list of variables into a sink (std::ostream&, 
+    * std::string& to append to, charBuffer / char array, fdSink or 
+    * callbackSink).
+    *
+    * @return number of bytes written
+    */
+   template<typename Sink, std::size_t N, typename T, typename... TRest>
+      typename std::enable_if<!std::is_same<typename std::decay<Sink>::type, writer>::value &&
+                              !std::is_same<typename std::decay<Sink>::type, context>::value &&
+                              !std::is_same<typename std::decay<Sink>::type, ringFile>::value, 
+                              std::size_t>::type
+      reflectTo(Sink&& sink, const modeList modeArg, 
+                callSite<N>& site,
+                const T& t, const TRest&... tRest)
+      {
+         writer oBuffer(sink);
+         return reflectTo(oBuffer, modeArg, site, t, tRest...);
+      }
+
+   /**
+    * @brief reflect given list of variables.
+    *
+    * @param modeArg - mode set from macro
+    * @param site - call site of the macro (names of all variables passed to it)
     * @param t - first variable passed to macro
     * @param tRest - all rest of the variables passed to macro
     *
     * @return 
     */
-   template<typename T, typename... TRest>
+   template<std::size_t N, typename T, typename... TRest>
       std::string reflect(const modeList modeArg, 
-                          std::string nameStr,
+                          callSite<N>& site,
                           const T& t, const TRest&... tRest)
       {
-         incrDepth();
-         mode = modeArg;
-         std::ostringstream oBuffer;
-         oBuffer << std::boolalpha;
-         _reflect(oBuffer, nameStr, t, tRest...);
-         decrDepth();
-         std::string ret = oBuffer.str();
-         return ret;
+         // formatted into a reused buffer, so that the only allocation is
+         // the returned string, of the exact size
+         scratchBuffer ret;
+         reflectStandalone(modeArg, [&]() { reflectTo(ret.str(), modeArg, site, t, tRest...); });
+         return ret.str();
+      }
+
+   /**
+    * @brief reflect given list of variables through snapshot snap into a sink 
+    * (writer, std::ostream&, std::string& to append to, charBuffer / char 
+    * array or fdSink): only what changed since the previous reflection 
+    * through snap is written, see snapshot.
+    *
+    * @return number of bytes written
+    */
+   template<typename Sink, std::size_t N, typename T, typename... TRest>
+      std::size_t reflectDiffTo(snapshot& snap, Sink&& sink, callSite<N>& site,
+                                const T& t, const TRest&... tRest)
+      {
+         static_assert(N == 1 + sizeof...(TRest), 
+                       "Number of names doesn't match number of variables");
+         const std::tuple<const T&, const TRest&...> vars(t, tRest...);
+         if constexpr (std::is_same<typename std::decay<Sink>::type, writer>::value)
+            return reflectDiffRecord(sink, snap, site, {reflectVariables<T, TRest...>, &vars});
+         else
+         {
+            writer oBuffer(sink);
+            return reflectDiffRecord(oBuffer, snap, site, {reflectVariables<T, TRest...>, &vars});
+         }
+      }
+
+   /**
+    * @brief reflect given list of variables through snapshot snap, see 
+    * reflectDiffTo
+    *
+    * @return changes since the previous reflection through snap
+    */
+   template<std::size_t N, typename T, typename... TRest>
+      std::string reflectDiff(snapshot& snap, callSite<N>& site,
+                              const T& t, const TRest&... tRest)
+      {
+         scratchBuffer ret;
+         reflectDiffTo(snap, ret.str(), site, t, tRest...);
+         return ret.str();
+      }
+
+   inline void siteStats::reflect(context& ctx) const
+   {
+      CppReflectTo(ctx, file, line, variables, calls, totalNanos, maxNanos, bytes, elements, truncations);
+   }
+
+   /**
+    * @brief Statistics of every call site used so far (or since the last 
+    * resetSiteStats), summed over all threads, by call site id. Empty unless
+    * CPPREFLECT_INSTRUMENT is 1. Counts of a reflection running at the same
+    * time may be partly in it.
+    */
+   inline std::vector<siteStats> siteStatsSnapshot()
+   {
+      std::vector<siteStats> ret;
+#if CPPREFLECT_INSTRUMENT
+      siteRegistry& registry = siteRegistry::global();
+      std::lock_guard<std::mutex> guard(registry.lock);
+      const std::uint64_t epoch = registry.epoch.load();
+      for(std::size_t id = 0; id < registry.sites.size(); id++)
+      {
+         const callSiteState* site = registry.sites[id];
+         if(!site) continue;
+         siteStats stats = id < registry.exited.size() ? registry.exited[id] : siteStats();
+         for(const siteCounterTable* table : registry.threads)
+         {
+            if(table->epoch.load(std::memory_order_relaxed) != epoch) continue;
+            if(const siteCounters* counters = table->find(static_cast<std::uint32_t>(id)))
+               counters->addTo(stats);
+         }
+         if(!stats.calls) continue;
+         stats.file = site->file;
+         stats.line = site->line;
+         for(std::size_t i = 0; i < site->names.size(); i++)
+         {
+            if(i) stats.variables += ", ";
+            stats.variables += site->names[i];
+         }
+         ret.push_back(std::move(stats));
+      }
+#endif
+      return ret;
+   }
+
+   /**
+    * @brief Start counting from zero again, for every call site and thread
+    */
+   inline void resetSiteStats()
+   {
+#if CPPREFLECT_INSTRUMENT
+      siteRegistry& registry = siteRegistry::global();
+      std::lock_guard<std::mutex> guard(registry.lock);
+      registry.exited.clear();
+      registry.epoch.fetch_add(1);
+#endif
+   }
+
+   /**
+    * @brief Write siteStatsSnapshot into a sink (see reflectTo), in List or
+    * CSV mode (or any other mode)
+    *
+    * @return number of bytes written
+    */
+   template<typename Sink>
+      std::size_t dumpSiteStats(Sink&& sink, const modeList modeArg = List)
+      {
+         const std::vector<siteStats> sites = siteStatsSnapshot();
+         return reflectTo(sink, modeArg, CppReflectCallSite(sites), sites);
       }
+
+   /**
+    * @brief Renders output of the Binary mode back into List/CSV/JSON text, 
+    * the text the mode would have printed under the options of the decoding
+    * thread. Names of call sites are remembered across decode calls, so a
+    * stream can be decoded chunk by chunk as long as chunks hold whole records.
+    */
+   class binaryDecoder {
+      public:
+         explicit binaryDecoder(modeList modeArg = List) : mode_(modeArg) {}
+
+         /**
+          * @brief Decode encoded into sink (std::ostream, std::string, ...)
+          *
+          * @return false if encoded is malformed, text of everything before
+          * the malformed part is still written.
+          */
+         template<typename Sink>
+            bool decode(std::string_view encoded, Sink&& sink)
+            {
+               writer out(sink);
+               return decode(encoded, out);
+            }
+
+         bool decode(std::string_view encoded, writer& out)
+         {
+            reader in{encoded};
+            while(in.ok && !in.atEnd())
+            {
+               const unsigned char tag = in.byte();
+               if(tag == TagSiteDef) siteDef(in);
+               else if(tag == TagSiteRef) siteRef(in);
+               else if(tag == TagRecord || tag == TagRecordPart || tag == TagTruncated)
+               {
+                  context ctx(out, mode_, context::nextDepth());
+                  if(tag == TagTruncated) truncated(in, ctx);
+                  else if(mode_ != JSON) record(in, ctx, tag);
+                  else
+                  {
+                     out.put('{');
+                     record(in, ctx, tag);
+                     out.write("}\n", 2);
+                  }
+               }
+               else in.ok = false;
+            }
+            return in.ok;
+         }
+
+      private:
+         /**
+          * @brief Bounds checked cursor over encoded bytes, reads past the 
+          * end clear ok and yield zeros.
+          */
+         struct reader {
+            std::string_view data;
+            std::size_t pos = 0;
+            bool ok = true;
+
+            bool atEnd() const { return pos >= data.size(); }
+            std::size_t remaining() const { return data.size() - pos; }
+            unsigned char peek() const { return atEnd() ? 0 : data[pos]; }
+
+            unsigned char byte()
+            {
+               if(atEnd()) { ok = false; return 0; }
+               return data[pos++];
+            }
+
+            std::uint64_t varint()
+            {
+               std::uint64_t value = 0;
+               for(int shift = 0; shift < 64; shift += 7)
+               {
+                  const unsigned char b = byte();
+                  value |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+                  if(!(b & 0x80)) return value;
+               }
+               ok = false;
+               return 0;
+            }
+
+            std::string_view bytes(std::uint64_t count)
+            {
+               if(count > remaining()) { ok = false; pos = data.size(); return {}; }
+               const std::string_view ret = data.substr(pos, count);
+               pos += count;
+               return ret;
+            }
+
+            template<typename T>
+               T littleEndian()
+               {
+                  T t{};
+                  const std::string_view b = bytes(sizeof(T));
+                  if(!ok) return t;
+                  char raw[sizeof(T)];
+                  for(std::size_t i = 0; i < sizeof(T); i++)
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+                     raw[i] = b[sizeof(T) - 1 - i];
+#else
+                     raw[i] = b[i];
+#endif
+                  std::memcpy(&t, raw, sizeof(T));
+                  return t;
+               }
+         };
+
+         void siteDef(reader& in)
+         {
+            const std::uint64_t id = in.varint(), count = in.varint();
+            if(count > in.remaining()) { in.ok = false; return; }
+            std::vector<std::string> names;
+            for(std::uint64_t i = 0; i < count && in.ok; i++)
+               names.emplace_back(in.bytes(in.varint()));
+            if(in.ok) sites_[id] = std::move(names);
+         }
+
+         /**
+          * @brief Names of a call site referred to by address, only trusted
+          * in the captures of an asyncQueue
+          */
+         void siteRef(reader& in)
+         {
+            const std::uint64_t address = in.littleEndian<std::uint64_t>();
+            if(!in.ok || !siteRefs_) { in.ok = false; return; }
+            callSiteState& site = *reinterpret_cast<callSiteState*>(static_cast<std::uintptr_t>(address));
+            std::vector<std::string>& names = sites_[site.id()];
+            if(names.size() == site.names.size()) return;
+            names.clear();
+            for(std::size_t i = 0; i < site.names.size(); i++) names.emplace_back(site.names[i]);
+         }
+
+         void record(reader& in, context& ctx, unsigned char tag)
+         {
+            // parts of a long record are joined before decoding it
+            std::string joined;
+            for(; tag == TagRecordPart && in.ok; tag = in.byte())
+               joined.append(in.bytes(in.littleEndian<std::uint32_t>()));
+            if(tag != TagRecord) { in.ok = false; return; }
+            std::string_view bytes = in.bytes(in.littleEndian<std::uint32_t>());
+            if(!joined.empty()) bytes = joined.append(bytes);
+            reader body{bytes};
+            while(in.ok && body.ok && !body.atEnd())
+            {
+               const unsigned char tag = body.byte();
+               if(tag == TagSiteDef) siteDef(body);
+               else if(tag == TagSiteRef) siteRef(body);
+               else if(tag == TagCall) call(body, ctx);
+               else body.ok = false;
+            }
+            // body of a record cut at maxBytes ends in the middle of a value
+            if(!body.ok && in.peek() != TagTruncated) in.ok = false;
+         }
+
+         void truncated(reader& in, context& ctx)
+         {
+            const std::uint64_t maxBytes = in.varint();
+            if(in.ok) truncatedMarker(ctx, maxBytes);
+         }
+
+         void call(reader& in, context& ctx)
+         {
+            const std::uint64_t id = in.varint(), count = in.varint();
+            auto site = sites_.find(id);
+            context nested(ctx.out, ctx.mode, ctx.depth);
+            nested.separate = ctx.separate;
+            for(std::uint64_t i = 0; i < count && in.ok; i++)
+            {
+               const bool named = site != sites_.end() && i < site->second.size();
+               nested.key = named ? std::string_view(site->second[i]) : "?";
+               const std::size_t mark = nested.path.push(nested.key);
+               value(in, nested);
+               nested.path.pop(mark);
+            }
+            ctx.separate = nested.separate;
+         }
+
+         void textMembers(std::string_view members, context& ctx)
+         {
+            if(ctx.mode == JSON) jsonMembers(ctx, members);
+            else ctx.out << members;
+         }
+
+         template<typename T>
+            void leaf(reader& in, context& ctx, const T& t)
+            {
+               if(in.ok) writeLeaf(ctx, t);
+            }
+
+         void value(reader& in, context& ctx)
+         {
+            switch(in.byte())
+            {
+               case TagBool: return leaf(in, ctx, in.byte() != 0);
+               case TagChar: return leaf(in, ctx, static_cast<char>(in.byte()));
+               case TagInt8: return leaf(in, ctx, in.littleEndian<std::int8_t>());
+               case TagInt16: return leaf(in, ctx, in.littleEndian<std::int16_t>());
+               case TagInt32: return leaf(in, ctx, in.littleEndian<std::int32_t>());
+               case TagInt64: return leaf(in, ctx, in.littleEndian<std::int64_t>());
+               case TagUInt8: return leaf(in, ctx, in.littleEndian<std::uint8_t>());
+               case TagUInt16: return leaf(in, ctx, in.littleEndian<std::uint16_t>());
+               case TagUInt32: return leaf(in, ctx, in.littleEndian<std::uint32_t>());
+               case TagUInt64: return leaf(in, ctx, in.littleEndian<std::uint64_t>());
+               case TagFloat: return leaf(in, ctx, in.littleEndian<float>());
+               case TagDouble: return leaf(in, ctx, in.littleEndian<double>());
+               case TagString:
+               case TagText: return leaf(in, ctx, in.bytes(in.varint()));
+               case TagContainer: return node(in, ctx, ContainerNode);
+               case TagTuple: return node(in, ctx, TupleNode);
+               case TagRange: return node(in, ctx, RangeNode);
+               case TagObject: return object(in, ctx);
+               case TagNumberArray: return numberArray(in, ctx);
+               case TagNotPrintable: return notPrintable(ctx);
+               case TagRemoved: return removedMarker(ctx, ctx.name());
+               case TagPointer: return pointer(in, ctx);
+               case TagPointerRef: return pointerRef(ctx, in.varint());
+               case TagNull: return nullPointer(ctx);
+               default: in.ok = false;
+            }
+         }
+
+         void node(reader& in, context& ctx, nodeKind kind)
+         {
+            const std::uint64_t size = kind == RangeNode ? 0 : in.varint();
+            if(!in.ok) return;
+            openNode(ctx, kind, size);
+            bool more = false;
+            for(std::uint64_t i = 0; in.ok; )
+            {
+               const unsigned char tag = in.peek();
+               if(tag == TagEnd) { in.byte(); break; }
+               if(tag == TagMore)
+               {
+                  in.byte();
+                  moreMarker(ctx);
+                  more = true;
+                  continue;
+               }
+               if(tag == TagSkip || tag == TagGap)
+               {
+                  in.byte();
+                  const std::uint64_t count = in.varint();
+                  if(tag == TagSkip && in.ok) skipMarker(ctx, count);
+                  i += count;
+                  continue;
+               }
+               const std::size_t mark = ctx.path.pushIndex(i++);
+               value(in, ctx);
+               ctx.path.pop(mark);
+            }
+            if(kind != RangeNode) return closeNode(ctx, kind);
+            const std::uint64_t count = in.varint();
+            if(in.ok) closeRange(ctx, count, more);
+         }
+
+         void pointer(reader& in, context& ctx)
+         {
+            const std::uint64_t id = in.varint();
+            if(!in.ok) return;
+            openPointer(ctx, id);
+            if(in.peek() == TagSkip)
+            {
+               in.byte();
+               const std::uint64_t count = in.varint();
+               if(in.ok) skipMarker(ctx, count);
+            }
+            else
+            {
+               const std::size_t mark = ctx.path.push("*");
+               value(in, ctx);
+               ctx.path.pop(mark);
+            }
+            closePointer(ctx);
+         }
+
+         void object(reader& in, context& ctx)
+         {
+            openNode(ctx, ObjectNode, 0);
+            while(in.ok)
+            {
+               const unsigned char tag = in.byte();
+               if(tag == TagEnd) break;
+               else if(tag == TagSiteDef) siteDef(in);
+               else if(tag == TagSiteRef) siteRef(in);
+               else if(tag == TagCall) call(in, ctx);
+               else if(tag == TagRecord || tag == TagRecordPart) record(in, ctx, tag);
+               else if(tag == TagTruncated) truncated(in, ctx);
+               else if(tag == TagHidden) hiddenMembers(ctx);
+               else if(tag == TagString) textMembers(in.bytes(in.varint()), ctx);
+               else in.ok = false;
+            }
+            closeNode(ctx, ObjectNode);
+         }
+
+         void numberArray(reader& in, context& ctx)
+         {
+            switch(in.byte())
+            {
+               case TagInt16: return numbers<std::int16_t>(in, ctx);
+               case TagInt32: return numbers<std::int32_t>(in, ctx);
+               case TagInt64: return numbers<std::int64_t>(in, ctx);
+               case TagUInt16: return numbers<std::uint16_t>(in, ctx);
+               case TagUInt32: return numbers<std::uint32_t>(in, ctx);
+               case TagUInt64: return numbers<std::uint64_t>(in, ctx);
+               case TagFloat: return numbers<float>(in, ctx);
+               case TagDouble: return numbers<double>(in, ctx);
+               default: in.ok = false;
+            }
+         }
+
+         template<typename T>
+            void numbers(reader& in, context& ctx)
+            {
+               const std::uint64_t count = in.varint();
+               if(!in.ok || count > in.remaining() / sizeof(T)) { in.ok = false; return; }
+               std::vector<T> elements(count);
+               for(T& e : elements) e = in.littleEndian<T>();
+               _processNameValue(ctx, elements);
+            }
+
+         modeList mode_;
+         std::unordered_map<std::uint64_t, std::vector<std::string>> sites_;
+         bool siteRefs_ = false; // set by asyncQueue for its captures
+         friend class asyncQueue;
+   };
+
+   /**
+    * @brief Deferred reflection, for latency critical threads. push() (see
+    * CppReflectAsync/CppReflectAsyncTo) only captures the variables, in the
+    * Binary encoding with the names of the call site, into a preallocated 
+    * lock-free multi-producer ring. A background thread per queue renders 
+    * the captures in the mode of the queue (List, CSV or JSON) into its sink,
+    * in the order the captures got their place in the ring. It sleeps on a
+    * condition variable while the ring is empty, a push only takes the lock
+    * to wake it up when it is asleep.
+    *
+    * When the ring has no room for a capture, it is dropped and counted by
+    * dropped() with fullPolicy Drop (the default), or push() spins until the
+    * background thread made room with fullPolicy Block. A capture bigger 
+    * than the whole ring is always dropped, options::maxBytes limits that.
+    */
+   class asyncQueue {
+      public:
+         enum fullPolicy { Drop = 0, Block };
+
+         explicit asyncQueue(std::ostream& sink, modeList modeArg = List,
+                             std::size_t capacityBytes = 1 << 20, fullPolicy policy = Drop)
+            : asyncQueue(&sink, fdSink{-1}, modeArg, capacityBytes, policy) {}
+
+         explicit asyncQueue(fdSink sink, modeList modeArg = List,
+                             std::size_t capacityBytes = 1 << 20, fullPolicy policy = Drop)
+            : asyncQueue(nullptr, sink, modeArg, capacityBytes, policy) {}
+
+         /**
+          * @brief Writes out everything pushed so far and stops the 
+          * background thread. No push may be running or follow.
+          */
+         ~asyncQueue()
+         {
+            stop_.store(true, std::memory_order_release);
+            {
+               std::lock_guard<std::mutex> lock(mutex_);
+            }
+            wake_.notify_one();
+            consumer_.join();
+         }
+
+         asyncQueue(const asyncQueue&) = delete;
+         asyncQueue& operator=(const asyncQueue&) = delete;
+
+         /**
+          * @brief Queue used by CppReflectAsync: List mode on std::cout
+          */
+         static asyncQueue& global()
+         {
+            static asyncQueue queue(std::cout);
+            return queue;
+         }
+
+         /**
+          * @brief Capture variables t of call site to be reflected later
+          *
+          * @return false if the capture was dropped
+          */
+         template<std::size_t N, typename... T>
+            bool push(callSite<N>& site, const T&... t)
+            {
+               static_assert(N == sizeof...(T), 
+                             "Number of names doesn't match number of variables");
+               const std::tuple<const T&...> vars(t...);
+               return pushCapture(site, {reflectVariables<T...>, &vars});
+            }
+
+         /**
+          * @brief Queue an already encoded (Binary mode) capture
+          */
+         bool push(std::string_view record)
+         {
+            const std::uint64_t count = slotsFor(record.size());
+            if(count > capacity_) return drop();
+            std::uint64_t pos = head_.load(std::memory_order_relaxed);
+            for(;;)
+            {
+               // the ring is consumed in order, so if the last slot needed 
+               // is free all the slots before it are free too
+               const std::uint64_t last = pos + count - 1;
+               const std::uint64_t seq = seq_[last & mask_].load(std::memory_order_acquire);
+               if(seq == last)
+               {
+                  if(head_.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) 
+                     break;
+               }
+               else if(seq < last)
+               {
+                  if(policy_ == Drop) return drop();
+                  std::this_thread::yield();
+                  pos = head_.load(std::memory_order_relaxed);
+               }
+               else pos = head_.load(std::memory_order_relaxed);
+            }
+            const std::uint32_t size = static_cast<std::uint32_t>(record.size());
+            const std::size_t offset = (pos & mask_) * slotSize;
+            std::memcpy(data_.get() + offset, &size, sizeof(size));
+            copyIn(offset + sizeof(size), record.data(), record.size());
+            for(std::uint64_t i = pos + count - 1; i > pos; i--)
+               seq_[i & mask_].store(i + 1, std::memory_order_relaxed);
+            seq_[pos & mask_].store(pos + 1, std::memory_order_release);
+            // pairs with the one of park(): either the consumer sees the 
+            // capture or this sees it sleeping
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(sleeping_.load(std::memory_order_relaxed) && sleeping_.exchange(false))
+            {
+               std::lock_guard<std::mutex> lock(mutex_);
+               wake_.notify_one();
+            }
+            return true;
+         }
+
+         /**
+          * @brief Wait until everything pushed so far is written into the sink
+          */
+         void flush()
+         {
+            const std::uint64_t target = head_.load(std::memory_order_acquire);
+            if(done_.load(std::memory_order_acquire) >= target) return;
+            std::unique_lock<std::mutex> lock(mutex_);
+            flushers_.fetch_add(1);
+            flushed_.wait(lock, [&]() { return done_.load() >= target; });
+            flushers_.fetch_sub(1);
+         }
+
+         /**
+          * @brief Number of captures dropped because the ring was full
+          */
+         std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+      private:
+         /**
+          * @brief A capture is a reflection of its own, even if pushed by a 
+          * reflect() API: it is rendered later, on another thread. Its call
+          * sites are sent by address, the consumer looks their names up.
+          */
+         class captureScope {
+            public:
+               captureScope() : outer_(context::current()), outerCapturing_(capturingSites())
+               {
+                  context::current() = nullptr;
+                  capturingSites() = true;
+               }
+
+               ~captureScope()
+               {
+                  context::current() = outer_;
+                  capturingSites() = outerCapturing_;
+               }
+
+               captureScope(const captureScope&) = delete;
+               captureScope& operator=(const captureScope&) = delete;
+
+            private:
+               context* const outer_;
+               const bool outerCapturing_;
+         };
+
+         /**
+          * @brief see push(callSite&, ...)
+          */
+         bool pushCapture(callSiteState& site, const variableList& vars)
+         {
+            const options& opts = options::current();
+            scratchBuffer recordBuffer;
+            std::string& record = recordBuffer.str();
+            std::size_t lengthAt = 0, maxBytes = opts.maxBytes;
+            bool truncated = false;
+            {
+               // like reflectTo(writer&) in Binary mode, but the length of
+               // the record is patched in afterwards instead of encoding 
+               // the body aside
+               const captureScope capture;
+               writer out(record);
+               context ctx(out, Binary, 0);
+               writeBinaryNames(out, site, opts);
+               out.put(TagRecord);
+               lengthAt = out.size();
+               out.writeLittleEndian(std::uint32_t(0));
+               if(maxBytes != options::unlimited) out.limit(out.size() + maxBytes);
+               openBinaryCall(out, site);
+               vars.reflect(ctx, site.names, vars.vars);
+               truncated = maxBytes != options::unlimited && out.full();
+               out.limit(writer::noLimit);
+               if(truncated)
+               {
+                  out.put(TagTruncated);
+                  out.writeVarint(maxBytes);
+               }
+            }
+            const std::size_t length = record.size() - lengthAt - sizeof(std::uint32_t) - 
+               (truncated ? 1 + writer::varintSize(maxBytes) : 0);
+            char bytes[sizeof(std::uint32_t)];
+            for(std::size_t i = 0; i < sizeof(bytes); i++) bytes[i] = static_cast<char>(length >> (8 * i));
+            record.replace(lengthAt, sizeof(bytes), bytes, sizeof(bytes));
+            return push(record);
+         }
+
+         static constexpr std::size_t slotSize = 64;
+         static constexpr std::size_t maxBatch = 1024;
+
+         asyncQueue(std::ostream* stream, fdSink fd, modeList modeArg, 
+                    std::size_t capacityBytes, fullPolicy policy)
+            : stream_(stream), fd_(fd), mode_(modeArg), policy_(policy)
+         {
+            capacity_ = 2;
+            while(capacity_ * slotSize < capacityBytes) capacity_ *= 2;
+            mask_ = capacity_ - 1;
+            // zeroed, so that no page fault hits a producer later
+            data_.reset(new char[capacity_ * slotSize]());
+            seq_.reset(new std::atomic<std::uint64_t>[capacity_]);
+            for(std::uint64_t i = 0; i < capacity_; i++) 
+               seq_[i].store(i, std::memory_order_relaxed);
+            consumer_ = std::thread([this]() { consume(); });
+         }
+
+         static std::uint64_t slotsFor(std::size_t size)
+         {
+            return (sizeof(std::uint32_t) + size + slotSize - 1) / slotSize;
+         }
+
+         bool drop()
+         {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+         }
+
+         void copyIn(std::size_t offset, const char* src, std::size_t len)
+         {
+            const std::size_t ringBytes = capacity_ * slotSize;
+            offset %= ringBytes;
+            const std::size_t first = std::min(len, ringBytes - offset);
+            std::memcpy(data_.get() + offset, src, first);
+            std::memcpy(data_.get(), src + first, len - first);
+         }
+
+         void consume()
+         {
+            binaryDecoder decoder(mode_);
+            decoder.siteRefs_ = true;
+            std::string wrapped;
+            for(;;)
+            {
+               const bool stopping = stop_.load(std::memory_order_acquire);
+               std::size_t records = 0;
+               if(stream_)
+               {
+                  writer out(*stream_);
+                  records = drain(decoder, out, wrapped);
+               }
+               else
+               {
+                  writer out(fd_);
+                  records = drain(decoder, out, wrapped);
+               }
+               if(records)
+               {
+                  done_.store(tail_);
+                  if(flushers_.load())
+                  {
+                     std::lock_guard<std::mutex> lock(mutex_);
+                     flushed_.notify_all();
+                  }
+                  continue;
+               }
+               if(!stopping) park();
+               else if(tail_ == head_.load(std::memory_order_acquire)) return;
+               else std::this_thread::yield(); // a push is still being copied
+            }
+         }
+
+         /**
+          * @brief Sleep until a push or the destructor wakes the consumer up,
+          * unless the next capture got ready in between
+          */
+         void park()
+         {
+            std::unique_lock<std::mutex> lock(mutex_);
+            sleeping_.store(true);
+            if(seq_[tail_ & mask_].load() == tail_ + 1 || stop_.load())
+            {
+               sleeping_.store(false);
+               return;
+            }
+            wake_.wait(lock, [this]() { return !sleeping_.load() || stop_.load(); });
+            sleeping_.store(false);
+         }
+
+         /**
+          * @brief Render the captures that are ready (up to maxBatch) into out
+          */
+         std::size_t drain(binaryDecoder& decoder, writer& out, std::string& wrapped)
+         {
+            const std::size_t ringBytes = capacity_ * slotSize;
+            std::size_t records = 0;
+            for(; records < maxBatch; records++)
+            {
+               const std::uint64_t pos = tail_;
+               if(seq_[pos & mask_].load(std::memory_order_acquire) != pos + 1) break;
+               std::uint32_t size;
+               const std::size_t offset = (pos & mask_) * slotSize;
+               std::memcpy(&size, data_.get() + offset, sizeof(size));
+               const std::size_t from = offset + sizeof(size);
+               if(from + size <= ringBytes)
+               {
+                  decoder.decode(std::string_view(data_.get() + from, size), out);
+               }
+               else
+               {
+                  wrapped.assign(data_.get() + from, ringBytes - from);
+                  wrapped.append(data_.get(), size - (ringBytes - from));
+                  decoder.decode(wrapped, out);
+               }
+               const std::uint64_t count = slotsFor(size);
+               for(std::uint64_t i = pos; i < pos + count; i++)
+                  seq_[i & mask_].store(i + capacity_, std::memory_order_release);
+               tail_ = pos + count;
+            }
+            return records;
+         }
+
+         std::ostream* const stream_;
+         const fdSink fd_;
+         const modeList mode_;
+         const fullPolicy policy_;
+         std::uint64_t capacity_ = 0; // in slots, a power of 2
+         std::uint64_t mask_ = 0;
+         std::unique_ptr<char[]> data_;
+         std::unique_ptr<std::atomic<std::uint64_t>[]> seq_;
+         alignas(64) std::atomic<std::uint64_t> head_{0}; // next position to claim
+         alignas(64) std::atomic<std::uint64_t> dropped_{0};
+         alignas(64) std::uint64_t tail_ = 0; // next position to render (consumer only)
+         std::atomic<std::uint64_t> done_{0}; // positions written into the sink
+         std::atomic<bool> stop_{false};
+         alignas(64) std::atomic<bool> sleeping_{false}; // consumer parked in wake_
+         std::atomic<std::size_t> flushers_{0}; // threads waiting in flush()
+         std::mutex mutex_;
+         std::condition_variable wake_, flushed_;
+         std::thread consumer_;
+   };
 }
 
 #endif // CppReflection_h_
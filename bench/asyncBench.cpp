@@ -0,0 +1,65 @@
+// Producer side cost of a reflection: formatting on the calling thread
+// (CppReflectAsListTo) against capturing for the background thread of an
+// asyncQueue (CppReflectAsyncTo), in nanoseconds per call. Output goes to
+// /dev/null. Cases are recorded with their median latency as nsPerCall.
+
+#include "benchHarness.h"
+#include <vector>
+#include <algorithm>
+#include <fcntl.h>
+
+namespace {
+
+   const int calls = 200000;
+
+   /**
+    * @brief Time every call of f, return {mean, p50, p99} in nanoseconds
+    */
+   template<typename F>
+      std::array<double, 3> latency(F f)
+      {
+         std::vector<double> ns(calls);
+         for(int i = 0; i < calls; i++)
+         {
+            auto start = std::chrono::steady_clock::now();
+            f(i);
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            ns[i] = elapsed.count();
+         }
+         double sum = 0;
+         for(double n : ns) sum += n;
+         std::sort(ns.begin(), ns.end());
+         return {{ sum / calls, ns[calls / 2], ns[calls * 99 / 100] }};
+      }
+}
+
+int main(int argc, char** argv)
+{
+   bench::suite suite(argc, argv, "asyncBench");
+   const int fd = open("/dev/null", O_WRONLY);
+   std::vector<int> histogram = {3, 1, 4, 1, 5, 9, 2, 6};
+   std::string state = "running";
+   double load = 0.75;
+
+   auto sync = latency([&](int i) {
+      CppReflectAsListTo(CppReflection::fdSink{fd}, i, load, state, histogram);
+   });
+
+   std::uint64_t dropped = 0;
+   std::array<double, 3> async;
+   {
+      CppReflection::asyncQueue queue(CppReflection::fdSink{fd}, CppReflection::List, 64 << 20);
+      async = latency([&](int i) {
+         CppReflectAsyncTo(queue, i, load, state, histogram);
+      });
+      queue.flush();
+      dropped = queue.dropped();
+   }
+   close(fd);
+
+   suite.record("sync", sync[1], {{"meanNs", sync[0]}, {"p99Ns", sync[2]}});
+   suite.record("async", async[1], {{"meanNs", async[0]}, {"p99Ns", async[2]},
+                {"dropped", static_cast<double>(dropped)}});
+
+   return suite.finish();
+}
@@ -0,0 +1,229 @@
+// Minimal benchmark harness shared by the benchmarks in this directory:
+// timing, heap allocation counting, a printed table and machine-readable
+// results (one JSON object per case and line) which a later run can be
+// compared against to catch regressions. Include it from exactly one
+// source file per benchmark executable, it replaces operator new.
+//
+// Every benchmark accepts:
+//   --out <file>         write the results to file
+//   --baseline <file>    compare against the results of an earlier run, a
+//                        case more than --tolerance percent slower (in
+//                        nsPerCall) is reported and fails the run
+//   --tolerance <pct>    default 10
+//   --quick              short runs, to check that everything still works
+
+#ifndef benchHarness_h_
+#define benchHarness_h_
+
+#include "CppReflection.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <new>
+#include <vector>
+
+namespace bench {
+
+   /**
+    * @brief Number of heap allocations so far, counted by operator new
+    */
+   inline std::atomic<std::size_t>& allocationCount()
+   {
+      static std::atomic<std::size_t> count(0);
+      return count;
+   }
+
+   /**
+    * @brief Results of one case. nsPerCall is what baselines are compared
+    * on, other metrics are informational.
+    */
+   struct result {
+      std::string caseName;
+      double nsPerCall = 0;
+      std::vector<std::pair<std::string, double>> metrics;
+   };
+
+   class suite {
+      public:
+         suite(int argc, char** argv, std::string name) : name_(std::move(name))
+         {
+            for(int i = 1; i < argc; i++)
+            {
+               const std::string_view arg = argv[i];
+               if(arg == "--quick") minSeconds_ = 0.01;
+               else if(arg == "--out" && i + 1 < argc) outPath_ = argv[++i];
+               else if(arg == "--baseline" && i + 1 < argc) baselinePath_ = argv[++i];
+               else if(arg == "--tolerance" && i + 1 < argc) tolerance_ = std::atof(argv[++i]);
+               else
+               {
+                  std::cerr << "Usage: " << argv[0] << " [--quick] [--out file]"
+                     " [--baseline file] [--tolerance pct]" << std::endl;
+                  std::exit(2);
+               }
+            }
+            std::cout << name_ << " :" << std::endl;
+            std::cout << std::left << std::setw(caseWidth) << "case" << std::right
+               << std::setw(14) << "ns/call" << std::setw(14) << "calls/s"
+               << std::setw(12) << "MB/s" << std::setw(14) << "bytes/call"
+               << std::setw(14) << "allocs/call" << std::endl;
+         }
+
+         /**
+          * @brief Measure throughput of f, which does one call and returns
+          * the number of bytes it produced. f is repeated until a run takes
+          * long enough to time, the best of 3 runs is kept.
+          */
+         template<typename F>
+            result run(const std::string& caseName, F f)
+            {
+               std::size_t bytes = f(); // warm up, caches and scratch buffers
+               std::size_t calls = 1;
+               double seconds = timeOf(f, calls, bytes);
+               while(seconds < minSeconds_ && calls < (std::size_t(1) << 40))
+               {
+                  calls *= seconds > 0 ? std::max<std::size_t>(2, std::min<std::size_t>(
+                     100, static_cast<std::size_t>(minSeconds_ / seconds) + 1)) : 100;
+                  seconds = timeOf(f, calls, bytes);
+               }
+               const std::size_t allocationsBefore = allocationCount();
+               for(int i = 0; i < 2; i++) seconds = std::min(seconds, timeOf(f, calls, bytes));
+               const double allocsPerCall =
+                  static_cast<double>(allocationCount() - allocationsBefore) / (2 * calls);
+
+               const double nsPerCall = seconds * 1e9 / calls;
+               const double callsPerSec = calls / seconds;
+               const double bytesPerCall = static_cast<double>(bytes);
+               const double bytesPerSec = bytesPerCall * callsPerSec;
+               std::cout << std::left << std::setw(caseWidth) << caseName << std::right
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(14) << nsPerCall << std::setw(14) << std::setprecision(0) << callsPerSec
+                  << std::setw(12) << std::setprecision(1) << bytesPerSec / 1e6
+                  << std::setw(14) << std::setprecision(0) << bytesPerCall
+                  << std::setw(14) << std::setprecision(2) << allocsPerCall << std::endl;
+               std::cout << std::defaultfloat << std::setprecision(6);
+               return record(caseName, nsPerCall, {{"callsPerSec", callsPerSec},
+                     {"bytesPerCall", bytesPerCall}, {"bytesPerSec", bytesPerSec},
+                     {"allocsPerCall", allocsPerCall}});
+            }
+
+         /**
+          * @brief Add the result of a case measured by the benchmark itself
+          */
+         result record(const std::string& caseName, double nsPerCall,
+                              std::vector<std::pair<std::string, double>> metrics)
+         {
+            if(metrics.empty() || metrics[0].first != "callsPerSec")
+            {
+               std::cout << std::left << std::setw(caseWidth) << caseName << std::right
+                  << std::fixed << std::setprecision(1) << std::setw(14) << nsPerCall 
+                  << std::defaultfloat << std::setprecision(6);
+               for(const auto& metric : metrics) std::cout << "  " << metric.first << " = " << metric.second;
+               std::cout << std::endl;
+            }
+            results_.push_back(result{caseName, nsPerCall, std::move(metrics)});
+            return results_.back();
+         }
+
+         /**
+          * @brief Write the results and compare them with the baseline
+          *
+          * @return exit code for main, 1 if a case regressed
+          */
+         int finish()
+         {
+            if(!outPath_.empty())
+            {
+               std::ofstream out(outPath_);
+               for(const result& r : results_)
+               {
+                  // the JSON mode of the library writes the results
+                  std::string line;
+                  const std::string& suiteName = name_;
+                  const std::string& caseName = r.caseName;
+                  const double nsPerCall = r.nsPerCall;
+                  const auto& metrics = r.metrics;
+                  CppReflectAsJSONTo(line, suiteName, caseName, nsPerCall, metrics);
+                  out << line;
+               }
+            }
+            if(baselinePath_.empty()) return 0;
+            std::ifstream in(baselinePath_);
+            if(!in)
+            {
+               std::cerr << "Can't read baseline " << baselinePath_ << std::endl;
+               return 1;
+            }
+            int regressions = 0;
+            for(std::string line; std::getline(in, line); )
+            {
+               const std::string caseName = field(line, "caseName");
+               const std::string baseNs = field(line, "nsPerCall");
+               for(const result& r : results_)
+               {
+                  if(r.caseName != caseName || baseNs.empty()) continue;
+                  const double before = std::atof(baseNs.c_str());
+                  const double change = before > 0 ? (r.nsPerCall / before - 1) * 100 : 0;
+                  if(change <= tolerance_) continue;
+                  std::cout << "REGRESSION " << name_ << "/" << caseName << ": "
+                     << before << " -> " << r.nsPerCall << " ns/call (+"
+                     << change << "%)" << std::endl;
+                  regressions++;
+               }
+            }
+            return regressions ? 1 : 0;
+         }
+
+      private:
+         static constexpr int caseWidth = 28;
+
+         template<typename F>
+            static double timeOf(F& f, std::size_t calls, std::size_t& bytes)
+            {
+               const auto start = std::chrono::steady_clock::now();
+               for(std::size_t i = 0; i < calls; i++) bytes = f();
+               const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+               return elapsed.count();
+            }
+
+         /**
+          * @brief Raw value of "key": in a results line, unquoted if a string
+          */
+         static std::string field(const std::string& line, const std::string& key)
+         {
+            const std::string tag = "\"" + key + "\":";
+            std::size_t from = line.find(tag);
+            if(from == std::string::npos) return std::string();
+            from += tag.size();
+            if(from < line.size() && line[from] == '"')
+               return line.substr(from + 1, line.find('"', from + 1) - from - 1);
+            return line.substr(from, line.find_first_of(",}", from) - from);
+         }
+
+         std::string name_;
+         std::string outPath_;
+         std::string baselinePath_;
+         double tolerance_ = 10;
+         double minSeconds_ = 0.2;
+         std::vector<result> results_;
+   };
+}
+
+// GCC sees the malloc/free behind the replaced operators once they are
+// inlined and takes them for mismatched with new/delete
+#if defined(__GNUC__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size)
+{
+   bench::allocationCount()++;
+   if(void* p = std::malloc(size ? size : 1)) return p;
+   throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+#endif // benchHarness_h_
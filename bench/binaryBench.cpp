@@ -0,0 +1,39 @@
+// Compares capturing a mixed state (numbers, strings, nested containers) in
+// the List text mode against the JSON and Binary modes, in time and bytes.
+
+#include "benchHarness.h"
+#include <vector>
+#include <map>
+
+namespace {
+
+   const int count = 100000;
+}
+
+int main(int argc, char** argv)
+{
+   bench::suite suite(argc, argv, "binaryBench");
+   std::vector<double> samples(count);
+   std::map<std::string, std::vector<int>> buckets;
+   for(int i = 0; i < count; i++)
+   {
+      samples[i] = i / 7.0;
+      buckets["bucket" + std::to_string(i % 100)].push_back(i);
+   }
+
+   std::string out;
+   const bench::result list = suite.run("List", [&]() {
+      out.clear();
+      return CppReflectAsListTo(out, samples, buckets);
+   });
+   suite.run("JSON", [&]() {
+      out.clear();
+      return CppReflectAsJSONTo(out, samples, buckets);
+   });
+   const bench::result binary = suite.run("Binary", [&]() {
+      out.clear();
+      return CppReflectAsBinaryTo(out, samples, buckets);
+   });
+   std::cout << "speedup = " << list.nsPerCall / binary.nsPerCall << std::endl;
+   return suite.finish();
+}
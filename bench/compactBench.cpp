@@ -0,0 +1,34 @@
+// Compares reflecting large contiguous containers of numbers one element
+// per line against the compact one line form (options::compactArrays).
+
+#include "benchHarness.h"
+#include <vector>
+
+namespace {
+
+   const int count = 1000000;
+}
+
+int main(int argc, char** argv)
+{
+   bench::suite suite(argc, argv, "compactBench");
+   std::vector<int> histogram(count);
+   std::vector<double> features(count);
+   for(int i = 0; i < count; i++)
+   {
+      histogram[i] = static_cast<int>((i * 7919LL) % 100003);
+      features[i] = i / 7.0;
+   }
+
+   std::string out;
+   auto reflectAll = [&]() {
+      out.clear();
+      return CppReflectAsListTo(out, histogram, features);
+   };
+
+   const double perElementNs = suite.run("perElement", reflectAll).nsPerCall;
+   CppReflection::options::defaults().compactArrays = true;
+   const double compactNs = suite.run("compact", reflectAll).nsPerCall;
+   std::cout << "speedup = " << perElementNs / compactNs << std::endl;
+   return suite.finish();
+}
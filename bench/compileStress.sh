@@ -0,0 +1,66 @@
+#!/bin/bash
+# Compile time and code size stress test: generates a translation unit with
+# many call sites reflecting many distinct types, compiles it against the
+# CppReflection.h found in the given include directory and prints the compile
+# time and the .text size of the result.
+#
+# Usage: compileStress.sh <include dir> <work dir> [sites] [types]
+
+set -e
+INCLUDE=$1
+WORK=$2
+SITES=${3:-2000}
+TYPES=${4:-400}
+CXX=${CXX:-g++}
+FLAGS=${STRESS_FLAGS:--std=c++17 -O2 -DNDEBUG -pthread}
+
+mkdir -p "$WORK"
+SRC=$WORK/compileStress.cpp
+{
+   echo '#include "CppReflection.h"'
+   echo '#include <array>'
+   echo '#include <map>'
+   echo '#include <tuple>'
+   echo '#include <vector>'
+   echo
+   echo '// every instance is a distinct type with a reflect method of its own'
+   echo 'template<int I> struct stressObject {'
+   echo '   int id = I;'
+   echo '   double ratio = I * 0.5;'
+   echo '   std::vector<int> values{I, I + 1, I + 2};'
+   echo '   std::tuple<int, std::string, char> info{I, "info", char(65 + I % 26)};'
+   echo '   std::array<short, I % 7 + 1> fixed{};'
+   echo '   void reflect(CppReflection::context& ctx) const { CppReflectTo(ctx, id, ratio, values, info, fixed); }'
+   echo '};'
+   echo
+   for ((i = 0; i < SITES; i++)); do
+      t=$((i % TYPES))
+      echo "std::size_t site$i(std::string& out) {"
+      echo "   stressObject<$t> object$i;"
+      echo "   std::map<int, std::array<long, $((t % 11 + 1))>> table$i{{$i, {}}};"
+      echo "   std::pair<float, stressObject<$(((t + 1) % TYPES))>> pair$i;"
+      echo "   const unsigned count$i = $i;"
+      case $((i % 4)) in
+         0) echo "   return CppReflectAsListTo(out, object$i, table$i, pair$i, count$i);" ;;
+         1) echo "   return CppReflectAsCSVTo(out, object$i, table$i, pair$i, count$i);" ;;
+         2) echo "   return CppReflectAsJSONTo(out, object$i, table$i, pair$i, count$i);" ;;
+         3) echo "   return CppReflectAsBinaryTo(out, object$i, table$i, pair$i, count$i);" ;;
+      esac
+      echo "}"
+   done
+   echo
+   echo 'int main() {'
+   echo '   std::string out;'
+   echo '   std::size_t total = 0;'
+   for ((i = 0; i < SITES; i++)); do echo "   total += site$i(out); out.clear();"; done
+   echo '   return total ? 0 : 1;'
+   echo '}'
+} > "$SRC"
+
+start=$(date '+%s.%N')
+$CXX $FLAGS -I "$INCLUDE" "$SRC" -o "$WORK/compileStress"
+end=$(date '+%s.%N')
+text=$(size -A "$WORK/compileStress" | awk '$1 == ".text" { print $2 }')
+"$WORK/compileStress"
+awk -v s="$start" -v e="$end" -v t="$text" -v n="$SITES" -v k="$TYPES" \
+   'BEGIN { printf "%d call sites, %d types: compile %.1f s, .text %d bytes\n", n, k, e - s, t }'
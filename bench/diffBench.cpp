@@ -0,0 +1,52 @@
+// Compares reflecting a large state every tick in full against diff
+// reflection through a snapshot, when nothing or one element changed.
+
+#include "benchHarness.h"
+#include <map>
+#include <vector>
+
+namespace {
+
+   const int count = 10000;
+
+   struct order {
+      int id = 0;
+      double price = 0;
+      std::vector<int> fills{1, 2, 3};
+      void reflect(CppReflection::context& ctx) const { CppReflectTo(ctx, id, price, fills); }
+   };
+}
+
+int main(int argc, char** argv)
+{
+   bench::suite suite(argc, argv, "diffBench");
+   std::vector<order> orders(count);
+   std::map<int, std::string> names;
+   for(int i = 0; i < count; i++)
+   {
+      orders[i].id = i;
+      orders[i].price = i / 8.0;
+      names[i] = "name" + std::to_string(i);
+   }
+
+   std::string out;
+   suite.run("full", [&]() {
+      out.clear();
+      return CppReflectAsListTo(out, orders, names);
+   });
+
+   CppReflection::snapshot snap;
+   CppReflectDiffTo(snap, out, orders, names);
+   suite.run("unchanged", [&]() {
+      out.clear();
+      return CppReflectDiffTo(snap, out, orders, names);
+   });
+
+   int tick = 0;
+   suite.run("oneChange", [&]() {
+      orders[count / 2].price = ++tick;
+      out.clear();
+      return CppReflectDiffTo(snap, out, orders, names);
+   });
+   return suite.finish();
+}
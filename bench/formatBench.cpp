@@ -0,0 +1,60 @@
+// Compares the writer's own scalar formatting (std::to_chars) against
+// formatting every value with its << operator (options::streamScalars), on
+// the variables of test.cpp scaled up 10^5 times.
+
+#include "benchHarness.h"
+#include <tuple>
+#include <vector>
+#include <set>
+#include <map>
+#include <list>
+
+namespace {
+
+   const int scale = 100000;
+}
+
+int main(int argc, char** argv)
+{
+   bench::suite suite(argc, argv, "formatBench");
+   std::vector<bool> var0s(scale, true);
+   std::vector<int> var1s(scale, 101);
+   std::vector<float> var2s(scale, 1.01f);
+   std::vector<std::string> var3s(scale, "Hello");
+   std::vector<const char*> var4s(scale, "World");
+   std::vector<int> var5;
+   std::list<float> var6;
+   std::map<std::string, int> var7;
+   std::set<std::array<int,3>> var8;
+   std::vector<std::tuple<const char*, const char*, const char*, int>> var9;
+   std::map<std::string, std::vector<std::string>> var10;
+   std::vector<std::tuple<long int, double, char>> var11s(scale, std::make_tuple(212100L, 1.012e-9, '&'));
+   for(int i = 0; i < scale; i++)
+   {
+      var5.insert(var5.end(), {3 + i, 5 + i, 7 + i});
+      var6.insert(var6.end(), {3.1f + i, 5.2f + i, 7.3f + i});
+      var7["One" + std::to_string(i)] = 1;
+      var7["Two" + std::to_string(i)] = 2;
+      var7["Three" + std::to_string(i)] = 3;
+      var8.insert({{51 + i, 52, 53}});
+      var8.insert({{61 + i, 62, 63}});
+      var8.insert({{71 + i, 72, 73}});
+      var9.emplace_back("United States", "California", "San Franscisco", 94115 + i);
+      var10["Colors" + std::to_string(i)] = {"Red", "Green", "Blue"};
+      var10["Shapes" + std::to_string(i)] = {"Square", "Circle", "Hexagone"};
+   }
+
+   std::string out;
+   auto reflectAll = [&]() {
+      out.clear();
+      return CppReflectAsListTo(out, var0s, var1s, var2s, var3s, var4s, var5, var6, var7, 
+                                var8, var9, var10, var11s);
+   };
+
+   CppReflection::options::defaults().streamScalars = true;
+   const double streamNs = suite.run("streamScalars", reflectAll).nsPerCall;
+   CppReflection::options::defaults().streamScalars = false;
+   const double fastNs = suite.run("toChars", reflectAll).nsPerCall;
+   std::cout << "speedup = " << streamNs / fastNs << std::endl;
+   return suite.finish();
+}
@@ -0,0 +1,34 @@
+// Cost of the per call site statistics (CPPREFLECT_INSTRUMENT) on short and
+// long reflections, and of taking a snapshot of them. Build it with
+// -DCPPREFLECT_INSTRUMENT=0 for the same cases without the statistics.
+
+#ifndef CPPREFLECT_INSTRUMENT
+#define CPPREFLECT_INSTRUMENT 1
+#endif
+#include "benchHarness.h"
+#include <vector>
+
+int main(int argc, char** argv)
+{
+   bench::suite suite(argc, argv, "instrumentBench");
+   const bool flag = true;
+   const int count = 42;
+   const double ratio = 0.25;
+   const std::string text = "instrumented";
+   std::vector<int> values(1000);
+   for(std::size_t i = 0; i < values.size(); i++) values[i] = static_cast<int>(i * 7);
+
+   std::string out;
+   suite.run("AsList/scalars", [&]() {
+      out.clear();
+      return CppReflectAsListTo(out, flag, count, ratio, text);
+   });
+   suite.run("AsList/container", [&]() {
+      out.clear();
+      return CppReflectAsListTo(out, values);
+   });
+   suite.run("siteStatsSnapshot", [&]() {
+      return CppReflection::siteStatsSnapshot().size();
+   });
+   return suite.finish();
+}
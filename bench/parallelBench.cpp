@@ -0,0 +1,50 @@
+// Dumping very large containers serially against in parallel chunks on the
+// formatPool (options::parallelThreads set to the number of cores, at least
+// 2). The speedup cases record serial ns / parallel ns, which should grow
+// with the number of cores; it stays around 1 on a single core machine.
+
+#include "benchHarness.h"
+#include <map>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+   bench::suite suite(argc, argv, "parallelBench");
+   std::vector<int> bigVector(2000000);
+   std::map<int, std::string> bigMap;
+   for(int i = 0; i < 2000000; i++)
+   {
+      bigVector[i] = i * 7;
+      if(i < 200000) bigMap[i] = "value" + std::to_string(i);
+   }
+
+   CppReflection::options parallel;
+   parallel.parallelThreads = std::max(2u, std::thread::hardware_concurrency());
+
+   std::string out;
+   auto compare = [&](const std::string& caseName, auto reflectOnce) {
+      const bench::result serial = suite.run(caseName + "/serial", reflectOnce);
+      CppReflection::options::scope scope(parallel);
+      const bench::result par = suite.run(caseName + "/parallel", reflectOnce);
+      suite.record(caseName + "/speedup", par.nsPerCall, {{"speedup", serial.nsPerCall / par.nsPerCall},
+            {"threads", static_cast<double>(parallel.parallelThreads)}});
+   };
+   compare("List/vector", [&]() {
+      out.clear();
+      return CppReflectAsListTo(out, bigVector);
+   });
+   compare("JSON/map", [&]() {
+      out.clear();
+      return CppReflectAsJSONTo(out, bigMap);
+   });
+   compare("List/map", [&]() {
+      out.clear();
+      return CppReflectAsListTo(out, bigMap);
+   });
+   compare("Binary/map", [&]() {
+      out.clear();
+      return CppReflectAsBinaryTo(out, bigMap);
+   });
+   return suite.finish();
+}
@@ -0,0 +1,67 @@
+// Cost of following pointers through a DAG shaped graph: layers of nodes,
+// each pointing to two nodes of the next layer, so the number of paths from
+// the root grows exponentially with the depth while the number of nodes 
+// grows linearly. Every node is printed once, the time per node should stay
+// flat as the graph grows (CSV mode, List indentation grows with the
+// depth).
+
+#include "benchHarness.h"
+#include <memory>
+#include <vector>
+
+namespace {
+
+   const int width = 8;
+
+   struct node {
+      int id = 0;
+      std::shared_ptr<node> left, right;
+      void reflect(CppReflection::context& ctx) const { CppReflectTo(ctx, id, left, right); }
+   };
+
+   /**
+    * @brief Root of a graph of layers * width nodes
+    */
+   std::shared_ptr<node> lattice(int layers)
+   {
+      std::vector<std::shared_ptr<node>> next;
+      int id = layers * width;
+      for(int layer = 0; layer < layers; layer++)
+      {
+         std::vector<std::shared_ptr<node>> current(width);
+         for(int i = 0; i < width; i++)
+         {
+            current[i] = std::make_shared<node>();
+            current[i]->id = --id;
+            if(!next.empty())
+            {
+               current[i]->left = next[i];
+               current[i]->right = next[(i + 1) % width];
+            }
+         }
+         next.swap(current);
+      }
+      return next[0];
+   }
+}
+
+int main(int argc, char** argv)
+{
+   bench::suite suite(argc, argv, "pointerBench");
+   CppReflection::options opts;
+   opts.followPointers = true;
+   CppReflection::options::scope scope(opts);
+
+   std::string out;
+   for(int layers : {16, 128, 1024})
+   {
+      const std::shared_ptr<node> root = lattice(layers);
+      const bench::result r = suite.run("CSV/" + std::to_string(layers * width) + "nodes", [&]() {
+         out.clear();
+         return CppReflectAsCSVTo(out, root);
+      });
+      suite.record("CSV/" + std::to_string(layers * width) + "nodes/perNode", 
+                   r.nsPerCall / (layers * width), {{"nodes", layers * width}});
+   }
+   return suite.finish();
+}
@@ -0,0 +1,57 @@
+// Reflecting a sequence without size() in one pass (a std::forward_list and
+// a lazily produced range) against the same numbers in a std::vector, in
+// List and Binary mode into a stream, where long Binary records go out in
+// parts instead of being encoded whole first.
+
+#include "benchHarness.h"
+#include <forward_list>
+#include <vector>
+
+namespace {
+
+   const int count = 100000;
+
+   // numbers count..1, produced while iterating
+   struct countdown {
+      int from;
+      struct iterator {
+         int n;
+         int operator*() const { return n; }
+         iterator& operator++() { --n; return *this; }
+         bool operator!=(const iterator& other) const { return n != other.n; }
+      };
+      iterator begin() const { return iterator{from}; }
+      iterator end() const { return iterator{0}; }
+   };
+
+   // stream buffer dropping everything, counting bytes only
+   struct nullBuf : std::streambuf {
+      std::size_t count = 0;
+      int_type overflow(int_type c) override { count++; return c; }
+      std::streamsize xsputn(const char*, std::streamsize n) override { count += n; return n; }
+   };
+}
+
+int main(int argc, char** argv)
+{
+   bench::suite suite(argc, argv, "rangeBench");
+   std::vector<int> vector;
+   for(int i = count; i > 0; i--) vector.push_back(i);
+   const std::forward_list<int> list(vector.begin(), vector.end());
+   const countdown lazy{count};
+
+   nullBuf buf;
+   std::ostream out(&buf);
+   auto bytes = [&](auto reflect) {
+      const std::size_t before = buf.count;
+      reflect();
+      return buf.count - before;
+   };
+   suite.run("List/vector", [&]() { return bytes([&]() { CppReflectAsListTo(out, vector); }); });
+   suite.run("List/forwardList", [&]() { return bytes([&]() { CppReflectAsListTo(out, list); }); });
+   suite.run("List/lazy", [&]() { return bytes([&]() { CppReflectAsListTo(out, lazy); }); });
+   suite.run("Binary/vector", [&]() { return bytes([&]() { CppReflectAsBinaryTo(out, vector); }); });
+   suite.run("Binary/forwardList", [&]() { return bytes([&]() { CppReflectAsBinaryTo(out, list); }); });
+   suite.run("Binary/lazy", [&]() { return bytes([&]() { CppReflectAsBinaryTo(out, lazy); }); });
+   return suite.finish();
+}
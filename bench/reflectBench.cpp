@@ -0,0 +1,164 @@
+// Throughput and allocations per call of every mode, over the shapes of
+// variables reflection is used with: scalars, wide argument lists, large
+// containers, deep nesting (like var10 of test.cpp), tuples and classes
+// with a reflect() API or CPPREFLECT_FIELDS (like Foo, Bar and Baz of 
+// test.cpp).
+
+#include "benchHarness.h"
+#include <tuple>
+#include <vector>
+#include <set>
+#include <map>
+
+namespace {
+
+   class Foo {
+      private:
+         long int a = 212100;
+         double b = 1.012e-9;
+         char c = '&';
+      public:
+         std::string reflect() const { return CppReflect(a, b, c); }
+   };
+
+   class Bar {
+      private:
+         int x = 7;
+         std::vector<int> y = {8, 9};
+      public:
+         void reflect(CppReflection::context& ctx) const { CppReflectTo(ctx, x, y); }
+   };
+
+   class Baz {
+      private:
+         long int a = 212100;
+         double b = 1.012e-9;
+         char c = '&';
+      public:
+         CPPREFLECT_FIELDS(Baz, a, b, c)
+   };
+}
+
+/**
+ * @brief Reflect into out in the mode given at run time
+ */
+#define BenchReflect(mode, ...) CppReflection::reflectTo(out, mode, \
+      CppReflectCallSite(__VA_ARGS__), __VA_ARGS__)
+
+int main(int argc, char** argv)
+{
+   bench::suite suite(argc, argv, "reflectBench");
+
+   bool flag = true;
+   int count = 101;
+   float ratio = 1.01f;
+   double precise = 1.012e-9;
+   std::string text = "Hello";
+   const char* ctext = "World";
+
+   std::vector<int> bigVector(100000);
+   std::map<std::string, int> bigMap;
+   std::set<std::array<int, 3>> bigSet;
+   for(int i = 0; i < 100000; i++)
+   {
+      bigVector[i] = i * 7;
+      if(i < 10000)
+      {
+         bigMap["key" + std::to_string(i)] = i;
+         bigSet.insert({{i, i + 1, i + 2}});
+      }
+   }
+
+   std::map<std::string, std::vector<std::string>> var10;
+   std::map<std::string, std::map<std::string, std::vector<std::vector<int>>>> deeper;
+   for(int i = 0; i < 1000; i++)
+   {
+      var10["Colors" + std::to_string(i)] = {"Red", "Green", "Blue"};
+      deeper["outer" + std::to_string(i % 10)]["inner" + std::to_string(i)] = {{1, 2}, {3, 4, 5}};
+   }
+
+   std::vector<std::tuple<const char*, const char*, const char*, int>> tuples(
+      10000, std::make_tuple("United States", "California", "San Franscisco", 94115));
+
+   std::vector<Foo> foos(1000);
+   std::vector<Bar> bars(1000);
+   std::vector<Baz> bazs(1000);
+
+   const std::pair<CppReflection::modeList, const char*> modes[] = {
+      {CppReflection::List, "List"}, {CppReflection::CSV, "CSV"},
+      {CppReflection::JSON, "JSON"}, {CppReflection::Binary, "Binary"} };
+
+   std::string out;
+   for(const auto& mode : modes)
+   {
+      const std::string prefix = std::string(mode.second) + "/";
+      const CppReflection::modeList m = mode.first;
+      suite.run(prefix + "scalars", [&]() {
+         out.clear();
+         return BenchReflect(m, flag, count, ratio, precise, text, ctext);
+      });
+      suite.run(prefix + "wide", [&]() {
+         out.clear();
+         return BenchReflect(m, flag, count, ratio, precise, text, ctext, 
+                             flag, count, ratio, precise, text, ctext,
+                             flag, count, ratio, precise, text, ctext);
+      });
+      suite.run(prefix + "vector", [&]() {
+         out.clear();
+         return BenchReflect(m, bigVector);
+      });
+      suite.run(prefix + "map", [&]() {
+         out.clear();
+         return BenchReflect(m, bigMap);
+      });
+      suite.run(prefix + "set", [&]() {
+         out.clear();
+         return BenchReflect(m, bigSet);
+      });
+      suite.run(prefix + "nested", [&]() {
+         out.clear();
+         return BenchReflect(m, var10, deeper);
+      });
+      suite.run(prefix + "tuples", [&]() {
+         out.clear();
+         return BenchReflect(m, tuples);
+      });
+      suite.run(prefix + "stringReflectObjects", [&]() {
+         out.clear();
+         return BenchReflect(m, foos);
+      });
+      suite.run(prefix + "sinkReflectObjects", [&]() {
+         out.clear();
+         return BenchReflect(m, bars);
+      });
+      suite.run(prefix + "fieldsObjects", [&]() {
+         out.clear();
+         return BenchReflect(m, bazs);
+      });
+   }
+
+   // the string returning macros
+   suite.run("AsList/scalars", [&]() {
+      return CppReflectAsList(flag, count, ratio, precise, text, ctext).size();
+   });
+   suite.run("AsCSV/scalars", [&]() {
+      return CppReflectAsCSV(flag, count, ratio, precise, text, ctext).size();
+   });
+   // calls suppressed by the sampling macros, only the first one reflects
+   suite.run("EveryN/suppressed", [&]() {
+      return CppReflectEveryN(1ull << 62, CppReflectAsListTo(out, flag, count, ratio));
+   });
+   suite.run("FirstN/suppressed", [&]() {
+      return CppReflectFirstN(1, CppReflectAsListTo(out, flag, count, ratio));
+   });
+   suite.run("PerSecond/suppressed", [&]() {
+      return CppReflectPerSecond(1, CppReflectAsListTo(out, flag, count, ratio));
+   });
+   // call site of a level turned off at run time
+   CppReflection::setLevel(CppReflection::Info);
+   suite.run("Debug/disabled", [&]() {
+      return CppReflectDebug(CppReflectAsListTo(out, flag, count, ratio));
+   });
+   CppReflection::setLevel(CppReflection::Trace);
+   return suite.finish();
+}
@@ -0,0 +1,42 @@
+// Compares writing every reflection into a log file through fdSink (one
+// write(2) per call) with appending it as a record of a memory-mapped
+// ringFile (memcpy only), formatting into a string being the lower bound.
+
+#include "benchHarness.h"
+#include <cstdio>
+#include <fcntl.h>
+
+int main(int argc, char** argv)
+{
+   bench::suite suite(argc, argv, "ringBench");
+   const char* logPath = "ringBench.log";
+   const char* ringPath = "ringBench.ring";
+   std::remove(logPath);
+   std::remove(ringPath);
+
+   int id = 0;
+   double price = 101.25;
+   const std::string symbol = "ABCD";
+   const std::vector<int> fills{100, 200, 50};
+
+   std::string out;
+   suite.run("string", [&]() {
+      out.clear();
+      return CppReflectAsCSVTo(out, ++id, price, symbol, fills);
+   });
+
+   const int fd = ::open(logPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   suite.run("fdSink/file", [&]() {
+      return CppReflectAsCSVTo(CppReflection::fdSink{fd}, ++id, price, symbol, fills);
+   });
+   ::close(fd);
+
+   CppReflection::ringFile ring(ringPath, 1 << 24);
+   suite.run("ringFile", [&]() {
+      return CppReflectAsCSVTo(ring, ++id, price, symbol, fills);
+   });
+
+   std::remove(logPath);
+   std::remove(ringPath);
+   return suite.finish();
+}
@@ -1,9 +1,39 @@
+// Trace call sites are compiled out of this program, see the leveled
+// reflection test
+#define CPPREFLECT_MIN_LEVEL CPPREFLECT_LEVEL_DEBUG
 #include "CppReflection.h"
 #include <tuple>
 #include <vector>
 #include <set>
 #include <map>
 #include <list>
+#include <forward_list>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <cstdio>
+#include <new>
+#include <memory>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+// Counts heap allocations, to check that reflecting the same shapes again
+// doesn't allocate, and keeps the largest one, to check that streaming a
+// long range takes constant memory.
+std::atomic<std::size_t> allocationCount(0);
+std::atomic<std::size_t> largestAllocation(0);
+
+void* operator new(std::size_t size)
+{
+   allocationCount++;
+   if(size > largestAllocation) largestAllocation = size;
+   if(void* p = std::malloc(size ? size : 1)) return p;
+   throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
 
 class Foo {
    private:
@@ -23,6 +53,72 @@ class Foo {
       }
 };
 
+class Bar {
+   private:
+      int x;
+      std::vector<int> y;
+   public:
+      Bar () : x(7), y({8, 9}) {}
+      void reflect(CppReflection::context& ctx) const
+      {
+         CppReflectTo(ctx, x, y);
+      }
+};
+
+// Fields registered once, private ones included, no reflect API to write
+class Baz {
+   private:
+      long int a = 42;
+      std::string b = "fields";
+      Bar c;
+      std::vector<double> d = {0.5, 1.5};
+   public:
+      CPPREFLECT_FIELDS(Baz, a, b, c, d)
+};
+
+// Node of a graph, children can be shared and parent makes cycles
+class GraphNode {
+   public:
+      explicit GraphNode (int v) : value(v) {}
+      int value;
+      std::shared_ptr<GraphNode> left, right;
+      GraphNode* parent = nullptr;
+      void reflect(CppReflection::context& ctx) const
+      {
+         CppReflectTo(ctx, value, left, right, parent);
+      }
+};
+
+// Value whose operator<< throws when it is negative
+struct Faulty {
+   int value = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, const Faulty& f)
+{
+   if(f.value < 0) throw std::runtime_error("negative");
+   return os << f.value;
+}
+// Lazily produced sequence from..1, begin() and end() only
+struct Countdown {
+   int from;
+   struct iterator {
+      int n;
+      int operator*() const { return n; }
+      iterator& operator++() { --n; return *this; }
+      bool operator!=(const iterator& other) const { return n != other.n; }
+   };
+   iterator begin() const { return iterator{from}; }
+   iterator end() const { return iterator{0}; }
+};
+
+// Stream buffer only counting what is written into it
+struct CountingBuf : std::streambuf {
+   std::size_t count = 0;
+   int_type overflow(int_type c) override { count++; return c; }
+   std::streamsize xsputn(const char*, std::streamsize n) override { count += n; return n; }
+};
+
 int main()
 {
    bool var0 = true;
@@ -40,10 +136,369 @@ int main()
       std::vector<std::string>> var10 = {{"Colors", {"Red", "Green", "Blue"}},
          {"Shapes", {"Square", "Circle", "Hexagone"}} };
    Foo var11;
+   Bar var12;
 
    std::cout << "Output of CppReflectAsList : " << std::endl;
    std::cout << CppReflectAsList(var0, var1 , p_var1, *p_var1, var2 , var3 , var4 , var5 , var6 , var7, var8, var9, var10, var11) << std::endl;
    std::cout << "Output of CppReflectAsCsv : " << std::endl;
    std::cout << CppReflectAsCSV(var0, var1 , p_var1, *p_var1, var2 , var3 , var4 , var5 , var6 , var7, var8, var9, var10, var11) << std::endl;
+   std::cout << "Output of CppReflectAsListTo(std::cout, ...) : " << std::endl;
+   CppReflectAsListTo(std::cout, var5, var11, var12);
+   std::cout << std::endl;
+   // a quote in a number is a digit separator, not a char literal
+   std::cout << CppReflectAsList(var1 + 1'000, ',', var1) << std::endl;
+
+   // Sinks other than streams and strings: a char buffer too small is cut
+   // and null terminated, a callback and a file descriptor get the whole
+   // output. Each call returns the number of bytes it wrote.
+   {
+      const std::string expected = CppReflectAsList(var1, var3);
+      char small[16];
+      std::memset(small, 'x', sizeof(small));
+      const std::size_t smallBytes = CppReflectAsListTo((CppReflection::charBuffer{small, sizeof(small)}), var1, var3);
+      const bool smallCut = smallBytes == sizeof(small) - 1 && small[sizeof(small) - 1] == '\0' && 
+                            expected.compare(0, smallBytes, small) == 0;
+      char array[64];
+      const std::size_t arrayBytes = CppReflectAsListTo(array, var1, var3);
+      const bool arrayWhole = arrayBytes == expected.size() && expected == array;
+      std::string called;
+      const std::size_t callbackBytes = CppReflectAsListTo((CppReflection::callbackSink{&called, 
+         [](void* target, const char* data, std::size_t len) { 
+            static_cast<std::string*>(target)->append(data, len); }}), var1, var3);
+      const bool callbackWhole = callbackBytes == expected.size() && called == expected;
+      std::FILE* file = std::tmpfile();
+      bool fdWhole = false;
+      if(file)
+      {
+         const std::size_t fdBytes = CppReflectAsListTo(CppReflection::fdSink{fileno(file)}, var1, var3);
+         std::string readBack(expected.size() + 1, '\0');
+         std::fseek(file, 0, SEEK_SET);
+         readBack.resize(std::fread(&readBack[0], 1, readBack.size(), file));
+         std::fclose(file);
+         fdWhole = fdBytes == expected.size() && readBack == expected;
+      }
+      std::cout << "Output of charBuffer, callbackSink and fdSink : " << std::endl;
+      std::cout << CppReflectAsList(smallBytes, smallCut, arrayWhole, callbackWhole, fdWhole) << std::endl;
+   }
+
+   // Bounded reflection: at most 2 elements per container, 1 level deep and
+   // 160 bytes in total.
+   CppReflection::options limits;
+   limits.maxElements = 2;
+   limits.maxDepth = 1;
+   {
+      CppReflection::options::scope scope(limits);
+      std::cout << "Output of bounded CppReflectAsList : " << std::endl;
+      std::cout << CppReflectAsList(var5, var10) << std::endl;
+      limits.maxBytes = 160;
+      std::cout << "Output of byte bounded CppReflectAsList : " << std::endl;
+      std::cout << CppReflectAsList(var5, var10) << std::endl;
+   }
+
+   // Stride sampling, jumping over random access containers, walking lists
+   CppReflection::options strided;
+   strided.maxElements = 3;
+   strided.sampling = CppReflection::options::Stride;
+   {
+      CppReflection::options::scope scope(strided);
+      const std::vector<int> stridedVector{0, 1, 2, 3, 4, 5, 6, 7};
+      const std::list<int> stridedList(stridedVector.begin(), stridedVector.end());
+      std::cout << "Output of stride sampled CppReflectAsList : " << std::endl;
+      std::cout << CppReflectAsList(stridedVector, stridedList) << std::endl;
+   }
+
+   // Contiguous containers of numbers printed on one line
+   CppReflection::options compact;
+   compact.compactArrays = true;
+   {
+      CppReflection::options::scope scope(compact);
+      std::array<float, 4> var13 = {{0.5, 1.25, -2, 1e10}};
+      std::cout << "Output of compact CppReflectAsList : " << std::endl;
+      std::cout << CppReflectAsList(var5, var6, var13) << std::endl;
+      // beyond maxDepth, hidden like the element by element form
+      CppReflection::options shallow = compact;
+      shallow.maxDepth = 0;
+      CppReflection::options::scope shallowScope(shallow);
+      std::cout << CppReflectAsList(var13) << std::endl;
+   }
+
+   // Binary mode decoded back into List and CSV text must match the text
+   // those modes print directly.
+   const std::string encoded = CppReflectAsBinary(var0, var1, var2, var3, var4, var5, var6, var7, var8, var9, var10, var11, var12);
+   std::string decodedList, decodedCSV;
+   CppReflection::binaryDecoder().decode(encoded, decodedList);
+   CppReflection::binaryDecoder(CppReflection::CSV).decode(encoded, decodedCSV);
+   const bool listMatches = decodedList == CppReflectAsList(var0, var1, var2, var3, var4, var5, var6, var7, var8, var9, var10, var11, var12);
+   const bool csvMatches = decodedCSV == CppReflectAsCSV(var0, var1, var2, var3, var4, var5, var6, var7, var8, var9, var10, var11, var12);
+   std::cout << "Output of decoded CppReflectAsBinary : " << std::endl;
+   std::cout << decodedList << std::endl;
+   std::string decodedJSON;
+   CppReflection::binaryDecoder(CppReflection::JSON).decode(encoded, decodedJSON);
+   const bool jsonMatches = decodedJSON == CppReflectAsJSON(var0, var1, var2, var3, var4, var5, var6, var7, var8, var9, var10, var11, var12);
+   std::cout << CppReflectAsList(listMatches, csvMatches, jsonMatches) << std::endl;
+
+   std::cout << "Output of CppReflectAsJSON : " << std::endl;
+   std::cout << CppReflectAsJSON(var0, var1, var2, var3, var4, var5, var6, var7, var8, var9, var10, var11, var12) << std::endl;
+
+   // Classes registered with CPPREFLECT_FIELDS, in every mode
+   Baz var14;
+   std::cout << "Output of CPPREFLECT_FIELDS : " << std::endl;
+   std::cout << CppReflectAsList(var14) << std::endl;
+   std::cout << CppReflectAsCSV(var14) << std::endl;
+   std::cout << CppReflectAsJSON(var14) << std::endl;
+   std::string decodedFields;
+   CppReflection::binaryDecoder().decode(CppReflectAsBinary(var14), decodedFields);
+   const bool fieldsMatch = decodedFields == CppReflectAsList(var14);
+   std::string fieldNames;
+   CppReflection::forEachField(var14, [&](std::string_view name, const auto&) { 
+      fieldNames.append(name).append(" "); });
+   std::cout << CppReflectAsList(fieldsMatch, fieldNames) << std::endl;
+
+   // Captured on this thread, reflected on the background thread of the
+   // queue: same text as reflecting right away.
+   std::ostringstream asyncOutput;
+   {
+      CppReflection::asyncQueue queue(asyncOutput);
+      CppReflectAsyncTo(queue, var5, var7, var11, var12);
+      CppReflectAsyncTo(queue, var9);
+      queue.flush();
+   }
+   const bool asyncMatches = asyncOutput.str() == CppReflectAsList(var5, var7, var11, var12) + CppReflectAsList(var9);
+   std::cout << "Output of CppReflectAsyncTo : " << std::endl;
+   std::cout << CppReflectAsList(asyncMatches) << std::endl;
+
+   // Diff reflection: the first one prints everything, the next ones only
+   // what was added, modified or removed since. Binary diffs decode into 
+   // the same text.
+   CppReflection::snapshot snap, binarySnap(CppReflection::Binary);
+   std::cout << "Output of CppReflectDiff : " << std::endl;
+   std::string listDiffs = CppReflectDiff(snap, var1, var5, var10, var12);
+   std::string binaryDiffs = CppReflectDiff(binarySnap, var1, var5, var10, var12);
+   std::cout << listDiffs << std::endl;
+   var1 = 102;
+   var5.pop_back();
+   var10["Shapes"][1] = "Triangle";
+   const std::string changes = CppReflectDiff(snap, var1, var5, var10, var12);
+   binaryDiffs += CppReflectDiff(binarySnap, var1, var5, var10, var12);
+   std::cout << "Output of CppReflectDiff after changes : " << std::endl;
+   std::cout << changes << std::endl;
+   listDiffs += changes + CppReflectDiff(snap, var1, var5, var10, var12);
+   binaryDiffs += CppReflectDiff(binarySnap, var1, var5, var10, var12);
+   std::string decodedDiffs;
+   CppReflection::binaryDecoder().decode(binaryDiffs, decodedDiffs);
+   const bool diffMatches = decodedDiffs == listDiffs;
+   std::cout << CppReflectAsList(diffMatches) << std::endl;
+   var1 = 101;
+   var5.push_back(7);
+   var10["Shapes"][1] = "Circle";
+
+   // Sampled reflection in a hot loop, suppressed calls don't reflect at all
+   std::string everyN, firstN, perSecond;
+   for(int i = 0; i < 10; i++)
+   {
+      everyN += CppReflectEveryN(4, CppReflectAsCSV(i));
+      CppReflectFirstN(2, CppReflectAsCSVTo(firstN, i));
+   }
+   for(int i = 0; i < 1000; i++) perSecond += CppReflectPerSecond(3, CppReflectAsCSV(i));
+   std::cout << "Output of CppReflectEveryN/FirstN/PerSecond : " << std::endl;
+   std::cout << everyN << std::endl << firstN << std::endl << perSecond << std::endl;
+
+   // Leveled reflection: Debug and Info call sites are compiled in and can
+   // be turned off at run time, Trace ones are not in the program at all
+   const int traceCounter = 1, debugCounter = 2;
+   std::string leveled = CppReflectTrace(CppReflectAsCSV(traceCounter*2));
+   leveled += CppReflectDebug(CppReflectAsCSV(debugCounter*2));
+   CppReflection::setLevel(CppReflection::Info);
+   leveled += CppReflectDebug(CppReflectAsCSV(debugCounter*3));
+   leveled += CppReflectInfo(CppReflectAsCSV(debugCounter*4));
+   CppReflection::setLevel(CppReflection::Trace);
+   (void) traceCounter;
+   std::ifstream self("/proc/self/exe", std::ios::binary);
+   const std::string program((std::istreambuf_iterator<char>(self)), std::istreambuf_iterator<char>());
+   // names of the call sites are stored without white-spaces, the searched
+   // names are built at run time so that they are not in the program
+   const bool traceInProgram = program.find(std::string("traceCounter") + "*2") != std::string::npos;
+   const bool debugInProgram = program.find(std::string("debugCounter") + "*2") != std::string::npos;
+   std::cout << "Output of CppReflectTrace/Debug/Info : " << std::endl;
+   std::cout << leveled << std::endl;
+   std::cout << CppReflectAsList(traceInProgram, debugInProgram) << std::endl;
+
+   // Pointers followed: the shared node is printed once, the parent pointers
+   // close cycles
+   auto root = std::make_shared<GraphNode>(1);
+   root->left = std::make_shared<GraphNode>(2);
+   root->right = std::make_shared<GraphNode>(3);
+   root->left->right = root->right->left = std::make_shared<GraphNode>(4);
+   root->left->parent = root->right->parent = root.get();
+   root->left->right->parent = root->left.get();
+   auto owned = std::make_unique<std::vector<int>>(var5);
+   CppReflection::options pointers;
+   pointers.followPointers = true;
+   {
+      CppReflection::options::scope scope(pointers);
+      std::cout << "Output of CppReflectAsList following pointers : " << std::endl;
+      std::cout << CppReflectAsList(root, owned, p_var1) << std::endl;
+      std::cout << CppReflectAsJSON(root, owned, p_var1) << std::endl;
+      std::string decodedPointers;
+      CppReflection::binaryDecoder().decode(CppReflectAsBinary(root, owned, p_var1), decodedPointers);
+      const bool pointersMatch = decodedPointers == CppReflectAsList(root, owned, p_var1);
+      std::cout << CppReflectAsList(pointersMatch) << std::endl;
+      // an object and its first member share their address, not their id
+      const GraphNode* rootNode = root.get();
+      const int* rootValue = &root->value;
+      std::cout << CppReflectAsList(rootNode, rootValue) << std::endl;
+   }
+
+   // Large containers formatted in parallel chunks, same output as serial
+   std::vector<int> large(5000);
+   std::map<int, std::string> largeMap;
+   std::vector<Foo> largeObjects(500);
+   for(int i = 0; i < 5000; i++)
+   {
+      large[i] = i * 7;
+      largeMap[i] = std::to_string(i);
+   }
+   auto listOf = [&]() { return CppReflectAsList(large, largeMap, largeObjects); };
+   auto jsonOf = [&]() { return CppReflectAsJSON(large, largeMap, largeObjects); };
+   auto binaryOf = [&]() { return CppReflectAsBinary(large, largeMap); };
+   const std::string serialList = listOf(), serialJSON = jsonOf(), serialBinary = binaryOf();
+   CppReflection::options parallel;
+   parallel.parallelThreads = 4;
+   parallel.parallelMinElements = 100;
+   {
+      CppReflection::options::scope scope(parallel);
+      bool parallelMatches = serialList == listOf() && serialJSON == jsonOf() && 
+                             serialBinary == binaryOf();
+      // reflected in parallel the first time, its name outgrows the path of
+      // the calling thread while chunks are formatted
+      const std::vector<int>& largeVectorNamedLongerThanAnyNameReflectedBefore_SoThatThePathOfTheCallingThreadGrowsWhileChunksAreFormatted_SoThatThePathOfTheCallingThreadGrowsWhileChunksAreFormatted_SoThatThePathOfTheCallingThreadGrowsWhileChunksAreFormatted_SoThatThePathOfTheCallingThreadGrowsWhileChunksAreFormatted_ = large;
+      const std::string longNamed = CppReflectAsList(largeVectorNamedLongerThanAnyNameReflectedBefore_SoThatThePathOfTheCallingThreadGrowsWhileChunksAreFormatted_SoThatThePathOfTheCallingThreadGrowsWhileChunksAreFormatted_SoThatThePathOfTheCallingThreadGrowsWhileChunksAreFormatted_SoThatThePathOfTheCallingThreadGrowsWhileChunksAreFormatted_);
+      {
+         CppReflection::options::scope serial(CppReflection::options::defaults());
+         parallelMatches = parallelMatches && 
+            longNamed == CppReflectAsList(largeVectorNamedLongerThanAnyNameReflectedBefore_SoThatThePathOfTheCallingThreadGrowsWhileChunksAreFormatted_SoThatThePathOfTheCallingThreadGrowsWhileChunksAreFormatted_SoThatThePathOfTheCallingThreadGrowsWhileChunksAreFormatted_SoThatThePathOfTheCallingThreadGrowsWhileChunksAreFormatted_);
+      }
+      // an exception of a chunk reaches the caller and frees the pool
+      std::vector<Faulty> faulty(1000);
+      faulty[900].value = -1;
+      bool rethrown = false;
+      try { CppReflectAsList(faulty); } catch(const std::runtime_error&) { rethrown = true; }
+      const CppReflection::formatPool::claimScope claimed(CppReflection::formatPool::global());
+      const bool poolReleased = static_cast<bool>(claimed);
+      std::cout << "Output of parallel formatting : " << std::endl;
+      std::cout << CppReflectAsList(parallelMatches, rethrown, poolReleased) << std::endl;
+   }
+
+   // Records written into a ring file that wraps around many times, only
+   // the latest ones are kept. They are read back through a second, read
+   // only mapping of the file, as a reader would after a crash.
+   const char* ringPath = "cppReflectTest.ring";
+   std::remove(ringPath);
+   {
+      CppReflection::ringFile ring(ringPath, 512);
+      for(int i = 0; i < 100; i++) CppReflectAsCSVTo(ring, i, var4);
+   }
+   {
+      CppReflection::ringFile ring;
+      const bool ringOpened = ring.openReadOnly(ringPath);
+      const std::size_t ringRecords = ring.lastRecords(1000).size();
+      const std::vector<std::string> lastRecords = ring.lastRecords(3);
+      std::cout << "Output of ring file : " << std::endl;
+      std::cout << CppReflectAsList(ringOpened, ringRecords, lastRecords) << std::endl;
+   }
+   std::remove(ringPath);
+
+   // Containers without size() are reflected in one pass, their count at
+   // the end. Long ones go out in chunks, decode the same and take constant
+   // memory.
+   std::forward_list<std::string> var15 = {"a", "b", "c"};
+   auto decoded = [](const std::string& encoded) {
+      std::string text;
+      CppReflection::binaryDecoder().decode(encoded, text);
+      return text; };
+   Countdown countdown{3};
+   std::cout << "Output of ranges without size() : " << std::endl;
+   std::cout << CppReflectAsList(var15, countdown) << std::endl;
+   std::cout << CppReflectAsCSV(var15, countdown) << std::endl;
+   std::cout << CppReflectAsJSON(var15, countdown) << std::endl;
+   std::cout << decoded(CppReflectAsBinary(var15, countdown)) << std::endl;
+   {
+      CppReflection::options few;
+      few.maxElements = 2;
+      CppReflection::options::scope scope(few);
+      Countdown countdown5{5};
+      std::cout << CppReflectAsList(countdown5) << std::endl;
+      // never reaches 0, only maxElements of it are walked
+      Countdown endless{-1};
+      std::cout << CppReflectAsList(endless) << std::endl;
+      std::cout << decoded(CppReflectAsBinary(endless)) << std::endl;
+   }
+   {
+      Countdown longCountdown{100000};
+      const std::string longBinary = CppReflectAsBinary(longCountdown);
+      const bool longDecodes = decoded(longBinary) == CppReflectAsList(longCountdown);
+      const bool longInParts = longBinary.size() > CppReflection::recordChunkBytes;
+      CountingBuf counting;
+      std::ostream countingOut(&counting);
+      Countdown hugeCountdown{2000000};
+      CppReflectAsBinaryTo(countingOut, hugeCountdown);
+      CppReflectAsListTo(countingOut, hugeCountdown);
+      largestAllocation = 0;
+      CppReflectAsBinaryTo(countingOut, hugeCountdown);
+      CppReflectAsListTo(countingOut, hugeCountdown);
+      const bool streamedMB = counting.count > (40u << 20);
+      const bool constantMemory = largestAllocation < CppReflection::recordChunkBytes * 2;
+      std::cout << CppReflectAsList(longDecodes, longInParts, streamedMB, constantMemory) << std::endl;
+   }
+
+   // Steady state reflection into a reused sink doesn't allocate (var11 is
+   // left out, its string returning reflect() allocates), returning the
+   // output as a string allocates only that string.
+   std::string reused;
+   auto allocationsOf = [&](auto reflectOnce) {
+      reflectOnce();
+      const std::size_t before = allocationCount;
+      for(int i = 0; i < 10; i++) reflectOnce();
+      return allocationCount - before;
+   };
+   std::size_t listAllocations = allocationsOf([&]() { reused.clear(); CppReflectAsListTo(reused, var0, var1, p_var1, var2, var3, var4, var5, var6, var7, var8, var9, var10, var12); });
+   std::size_t csvAllocations = allocationsOf([&]() { reused.clear(); CppReflectAsCSVTo(reused, var0, var1, p_var1, var2, var3, var4, var5, var6, var7, var8, var9, var10, var12); });
+   std::size_t jsonAllocations = allocationsOf([&]() { reused.clear(); CppReflectAsJSONTo(reused, var0, var1, p_var1, var2, var3, var4, var5, var6, var7, var8, var9, var10, var12); });
+   std::size_t binaryAllocations = allocationsOf([&]() { reused.clear(); CppReflectAsBinaryTo(reused, var0, var1, p_var1, var2, var3, var4, var5, var6, var7, var8, var9, var10, var12); });
+   std::size_t stringAllocations = allocationsOf([&]() { CppReflectAsList(var0, var1, var2, var3, var4, var5, var6, var7, var8, var9, var10, var12); });
+   std::size_t diffAllocations = allocationsOf([&]() { reused.clear(); CppReflectDiffTo(snap, reused, var1, var5, var10, var12); });
+   std::size_t pointerAllocations = allocationsOf([&]() { 
+      CppReflection::options::scope scope(pointers);
+      reused.clear(); 
+      CppReflectAsListTo(reused, root, owned); });
+   std::cout << "Output of allocation count test (10 reflections each) : " << std::endl;
+   std::cout << CppReflectAsList(listAllocations, csvAllocations, jsonAllocations, binaryAllocations, stringAllocations, diffAllocations, pointerAllocations) << std::endl;
+
+   // Reflect the same variables from many threads at once, in alternating
+   // modes. Every output must match the one produced by the main thread.
+   const std::string listRef = CppReflectAsList(var7, var10, var11, var12);
+   const std::string csvRef = CppReflectAsCSV(var7, var10, var11, var12);
+   std::atomic<int> mismatchCount(0);
+   std::vector<std::thread> threads;
+   for(int i = 0; i < 8; i++)
+   {
+      threads.emplace_back([&, i]() {
+         for(int j = 0; j < 2000; j++)
+         {
+            if((i + j) % 2)
+            {
+               if(CppReflectAsList(var7, var10, var11, var12) != listRef) mismatchCount++;
+            }
+            else
+            {
+               if(CppReflectAsCSV(var7, var10, var11, var12) != csvRef) mismatchCount++;
+            }
+         }
+      });
+   }
+   for(auto& th : threads) th.join();
+   int mismatches = mismatchCount;
+   std::cout << "Output of multi-threaded stress test : " << std::endl;
+   std::cout << CppReflectAsList(threads.size(), mismatches) << std::endl;
    return 0;
 }
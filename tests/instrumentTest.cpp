@@ -0,0 +1,54 @@
+// Per call site statistics (CPPREFLECT_INSTRUMENT changes the call site
+// layout, so it must be the same in every translation unit of a program:
+// this test is a program of its own, test.cpp keeps the defaults). Its
+// terminal output is kept in instrumentTest.output.
+
+#define CPPREFLECT_INSTRUMENT 1
+#include "CppReflection.h"
+#include <vector>
+
+int main()
+{
+   // three calls of one call site, the last one cut by maxBytes
+   CppReflection::resetSiteStats();
+   const std::vector<int> counted{1, 2, 3};
+   std::string countedOut;
+   auto reflectCounted = [&]() { CppReflectAsListTo(countedOut, counted); };
+   reflectCounted();
+   reflectCounted();
+   {
+      CppReflection::options small;
+      small.maxBytes = 10;
+      CppReflection::options::scope scope(small);
+      reflectCounted();
+   }
+
+   const std::vector<CppReflection::siteStats> sites = CppReflection::siteStatsSnapshot();
+   const std::size_t siteCount = sites.size();
+   const CppReflection::siteStats stats = siteCount ? sites[0] : CppReflection::siteStats();
+   const std::string& variables = stats.variables;
+   const std::uint64_t calls = stats.calls, elements = stats.elements;
+   const std::uint64_t truncations = stats.truncations;
+   const bool bytesMatch = stats.bytes == countedOut.size();
+   const bool timed = stats.maxNanos > 0 && stats.totalNanos >= stats.maxNanos;
+   std::string dumped;
+   CppReflection::dumpSiteStats(dumped, CppReflection::CSV);
+   const bool dumpHasSite = dumped.find("variables , counted") != std::string::npos;
+   std::cout << "Output of call site statistics : " << std::endl;
+   std::cout << CppReflectAsList(siteCount, variables, calls, elements, truncations, bytesMatch, timed, dumpHasSite) << std::endl;
+
+   // the elements of a container formatted in parallel count on the caller
+   CppReflection::resetSiteStats();
+   const std::vector<int> large(100000, 7);
+   {
+      CppReflection::options parallel;
+      parallel.parallelThreads = 4;
+      CppReflection::options::scope scope(parallel);
+      std::string largeOut;
+      CppReflectAsListTo(largeOut, large);
+   }
+   const std::vector<CppReflection::siteStats> parallelSites = CppReflection::siteStatsSnapshot();
+   const std::uint64_t parallelElements = parallelSites.empty() ? 0 : parallelSites[0].elements;
+   std::cout << CppReflectAsList(parallelElements) << std::endl;
+   return 0;
+}
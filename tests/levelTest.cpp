@@ -0,0 +1,39 @@
+// Leveled reflection built with a raised CPPREFLECT_MIN_LEVEL (a program of
+// its own: the level has to be the same in every translation unit). Call
+// sites compiled out are used the same ways as the ones compiled in and
+// have the same types. Its terminal output is kept in levelTest.output.
+
+#define CPPREFLECT_MIN_LEVEL CPPREFLECT_LEVEL_INFO
+#include "CppReflection.h"
+#include <type_traits>
+
+int main()
+{
+   int counter = 0;
+   auto next = [&]() { return ++counter; };
+   (void) next; // only used by call sites compiled out
+
+   // Trace and Debug are compiled out: arguments not evaluated
+   std::string appended = "csv:";
+   appended += CppReflectDebug(CppReflectAsCSV(next()));
+   appended += CppReflectInfo(CppReflectAsCSV(counter));
+   std::cout << CppReflectTrace(CppReflectAsList(next())) << CppReflectDebug(CppReflectAsList(next()));
+   std::cout << CppReflectInfo(CppReflectAsList(appended));
+
+   auto offText = CppReflectDebug(CppReflectAsList(next()));
+   auto onText = CppReflectInfo(CppReflectAsList(counter));
+   auto offWritten = CppReflectTrace(CppReflectAsListTo(std::cout, next()));
+   auto onWritten = CppReflectInfo(CppReflectAsListTo(std::cout, counter));
+   auto offSampled = CppReflectDebug(CppReflectEveryN(2, CppReflectAsJSONTo(std::cout, next())));
+   auto offCaptured = CppReflectDebug(CppReflectAsync(next()));
+   static_assert(std::is_same<decltype(offText), decltype(onText)>::value, "");
+   static_assert(std::is_same<decltype(offWritten), decltype(onWritten)>::value, "");
+   static_assert(std::is_same<decltype(offSampled), std::size_t>::value, "");
+   static_assert(std::is_same<decltype(offCaptured), bool>::value, "");
+
+   const bool offEmpty = offText.empty() && offWritten == 0 && offSampled == 0 && !offCaptured;
+   const bool onWrote = !onText.empty() && onWritten == onText.size();
+   std::cout << "Output of compiled out levels : " << std::endl;
+   std::cout << CppReflectAsList(counter, offEmpty, onWrote) << std::endl;
+   return 0;
+}
@@ -0,0 +1,51 @@
+// Renders the output of CppReflection's Binary mode (CppReflectAsBinary,
+// CppReflectAsBinaryTo) back into the List, CSV or JSON text.
+//
+// Usage: cppReflectDecode [--csv|--json] [--compact] [file]
+// Reads standard input if no file is given.
+
+#include "CppReflection.h"
+#include <fstream>
+#include <iterator>
+
+int main(int argc, char** argv)
+{
+   CppReflection::modeList mode = CppReflection::List;
+   CppReflection::options opts = CppReflection::options::defaults();
+   const char* path = nullptr;
+   for(int i = 1; i < argc; i++)
+   {
+      const std::string_view arg = argv[i];
+      if(arg == "--csv") mode = CppReflection::CSV;
+      else if(arg == "--json") mode = CppReflection::JSON;
+      else if(arg == "--compact") opts.compactArrays = true;
+      else if(arg.size() > 1 && arg[0] == '-')
+      {
+         std::cerr << "Usage: " << argv[0] << " [--csv|--json] [--compact] [file]" << std::endl;
+         return 2;
+      }
+      else path = argv[i];
+   }
+
+   std::ifstream file;
+   if(path)
+   {
+      file.open(path, std::ios::binary);
+      if(!file)
+      {
+         std::cerr << argv[0] << ": can't open " << path << std::endl;
+         return 1;
+      }
+   }
+   std::istream& in = path ? file : std::cin;
+   const std::string encoded((std::istreambuf_iterator<char>(in)), 
+                             std::istreambuf_iterator<char>());
+
+   CppReflection::options::scope scope(opts);
+   if(!CppReflection::binaryDecoder(mode).decode(encoded, std::cout))
+   {
+      std::cerr << argv[0] << ": malformed input" << std::endl;
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,41 @@
+// Prints the last complete records of a CppReflection::ringFile, e.g. what a
+// process reflected right before it crashed or was killed. Records cut short
+// by the crash are skipped.
+//
+// Usage: cppReflectRing [-n count] <ring file>
+// count defaults to 10, records are printed oldest first, one per line.
+
+#include "CppReflection.h"
+#include <cstdlib>
+
+int main(int argc, char** argv)
+{
+   std::size_t count = 10;
+   const char* path = nullptr;
+   bool usage = false;
+   for(int i = 1; i < argc; i++)
+   {
+      const std::string_view arg = argv[i];
+      if(arg == "-n" && i + 1 < argc) count = std::strtoull(argv[++i], nullptr, 10);
+      else if(arg.size() > 1 && arg[0] == '-') usage = true;
+      else path = argv[i];
+   }
+   if(usage || !path)
+   {
+      std::cerr << "Usage: " << argv[0] << " [-n count] <ring file>" << std::endl;
+      return 2;
+   }
+
+   CppReflection::ringFile ring;
+   if(!ring.openReadOnly(path))
+   {
+      std::cerr << argv[0] << ": " << path << " isn't a ring file" << std::endl;
+      return 1;
+   }
+   for(const std::string& record : ring.lastRecords(count))
+   {
+      std::cout << record;
+      if(record.empty() || record.back() != '\n') std::cout << '\n';
+   }
+   return 0;
+}